@@ -1,22 +1,62 @@
 /** \file
  * Gyro classes borrowed from the Rat Pack!
  * The gyro can take up to 15 seconds to become usable.
+ *
+ * Only the gyro's own task touches the integrator.  Other tasks read a snapshot it
+ * publishes through a seqlock after every batch, and Zero() and Reset() just ask: the
+ * gyro task applies them before its next sample so none is ever lost.
+ *
+ * Calibration only gives the bias a starting point.  It drifts as the sensor warms, so
+ * GyroBiasFilter keeps learning it whenever the drivetrain (SetStill) and the gyro both
+ * say the robot is still, and the angle is integrated against the latest estimate.
  */
 
 #include "ADXRS453Z.h"
 #include <cstdarg>
+#include <math.h>
+#include <string.h>
 
-int ADXRS453ZUpdateFunction(int pointer_val) {
+//Robot
+#include "DataLog.h"
+#include "RobotParams.h"
+#include "RobotTime.h"
+#include "TaskJitter.h"
+#include "TaskScheduler.h"
+
+/**
+ * The gyro's own task: reads the sensor every GYRO_SAMPLE_PERIOD on the control core.
+ * WPILib gives us no SPI accumulator so each sample is its own transaction, they are
+ * batched on our side and the batch is integrated together.
+ */
+int ADXRS453ZUpdateFunction(intptr_t pointer_val) {
 	ADXRS453Z * gyro = (ADXRS453Z *) pointer_val;
+	TaskJitter jitter(GYRO_TASKNAME);
+	uint64_t uPeriod = SecondsToNs(GYRO_SAMPLE_PERIOD);
+	uint64_t uNextSample = GetMonotonicNs();
+
+	TaskScheduler::ConfigureTask(GYRO_TASKNAME);
+
 	while (true)
 	{
 		gyro->Update();
-		Wait(0.01);
+
+		// sleep to an absolute time so the samples stay evenly spaced
+
+		uNextSample += uPeriod;
+
+		if(uNextSample < GetMonotonicNs())
+		{
+			uNextSample = GetMonotonicNs();
+		}
+
+		jitter.SleepUntil(uNextSample);
 	}
 	return 0;
 }
 
-ADXRS453Z::ADXRS453Z() {
+ADXRS453Z::ADXRS453Z()
+: angle_integrator(GYRO_INTEGRATION), offset_integrator(GYRO_INTEGRATION),
+  bias_filter(GYRO_BIAS_WALK, GYRO_BIAS_NOISE) {
 	spi = new SPI(SPI::kOnboardCS0);
 	spi->SetClockRate(4000000); //4 MHz (rRIO max, gyro can go high)
 	spi->SetClockActiveHigh();
@@ -32,17 +72,41 @@ ADXRS453Z::ADXRS453Z() {
 	data[2] = 0;
 	data[3] = 0;
 	iLoop = 0;
+	batch_count = 0;
+	zero_from = -1;
+	last_sample_ns = 0;
+	calibration_start_ns = 0;
+	still_hint.store(false);
+	still = false;
+	zero_requests.store(0);
+	reset_requests.store(0);
+	zeros_applied = 0;
+	resets_applied = 0;
+	snapshot_sequence.store(0);
+
+	for (int i = 0; i < GYRO_SNAPSHOT_WORDS; i++)
+	{
+		snapshot_words[i].store(0);
+	}
 
-	accumulated_angle = 0.0;
 	current_rate = 0.0;
-	accumulated_offset = 0.0;
 	rate_offset = 0.0;
-	update_timer = new Timer();
-	update_timer->Start();
 	calibration_timer = new Timer();
 	calibration_timer->Start();
 
-	update_task = new Task("tADSRX543Z", (FUNCPTR) &ADXRS453ZUpdateFunction); //TODO: this should give a unique name for each gyro object
+	drift_start_ns = 0;
+	drift_start_angle = 0.0;
+	stats_start_ns = GetMonotonicNs();
+	stats_samples = 0;
+	sampleRateKey = Telemetry::Intern("Gyro samples/s", TELEMETRY_RATE_SLOW);
+	transferKey = Telemetry::Intern("Gyro SPI p99 us", TELEMETRY_RATE_SLOW);
+	latencyKey = Telemetry::Intern("Gyro latency p99 us", TELEMETRY_RATE_SLOW);
+	maxLatencyKey = Telemetry::Intern("Gyro latency max us", TELEMETRY_RATE_SLOW);
+	driftKey = Telemetry::Intern("Gyro drift deg/min", TELEMETRY_RATE_SLOW);
+	biasKey = Telemetry::Intern("Gyro bias deg/s", TELEMETRY_RATE_SLOW);
+	stillKey = Telemetry::Intern("Gyro still", TELEMETRY_RATE_NORMAL, true);
+
+	update_task = new Task(GYRO_TASKNAME, (FUNCPTR) &ADXRS453ZUpdateFunction); //TODO: this should give a unique name for each gyro object
 	task_started = false;
 }
 
@@ -53,7 +117,7 @@ void ADXRS453Z::Start() {
 	}
 	else
 	{
-		update_task->Start((int) this);
+		update_task->Start((intptr_t)this);
 		task_started = true;
 	}
 }
@@ -65,16 +129,38 @@ void ADXRS453Z::Stop() {
 	}
 }
 
+///Reads one sample, and integrates the batch once it has GYRO_BATCH_SAMPLES
 void ADXRS453Z::Update() {
-	//calibration_timer->Start();
+	uint64_t uStart;
+	uint64_t uEnd;
+
+	ApplyCommands();
 	check_parity(command);
+	uStart = GetMonotonicNs();
 	spi->Transaction(command, data, DATA_SIZE); //perform transaction, get error code
+	uEnd = GetMonotonicNs();
+	DataLog::Record(DATALOG_TYPE_SPI, SPI::kOnboardCS0, data[0], data[1], data[2], data[3]); //for replay
 
-	if (calibration_timer->Get() < WARM_UP_PERIOD)
+	transfer_time.Record(uEnd - uStart);
+	batch_rate[batch_count] = ((float) assemble_sensor_data(data)) / 80.0;
+	batch_time_ns[batch_count] = uStart + (uEnd - uStart) / 2;
+	batch_count++;
+	stats_samples++;
+
+	if (batch_count < GYRO_BATCH_SAMPLES)
 	{
-		lastTime = thisTime = update_timer->Get();
 		return;
 	}
+
+	if (calibration_timer->Get() < WARM_UP_PERIOD)
+	{
+		// calibration will integrate from the last sample of the warm up
+
+		last_sample_ns = batch_time_ns[batch_count - 1];
+		calibration_start_ns = last_sample_ns;
+		offset_integrator.Restart();
+		offset_integrator.Add(batch_rate[batch_count - 1], last_sample_ns);
+	}
 	else if (calibration_timer->Get() < CALIBRATE_PERIOD)
 	{
 		Calibrate();
@@ -82,69 +168,251 @@ void ADXRS453Z::Update() {
 	else
 	{
 		UpdateData();
+		MeasureDrift();
+	}
+
+	PublishSnapshot();
+	latency.Record(GetMonotonicNs() - batch_time_ns[0]);
+	batch_count = 0;
+	zero_from = -1;
+	DataLog::Record(DATALOG_TYPE_GYRO, ENDPOINT_NONE, current_rate, angle_integrator.GetAngle(),
+			rate_offset, still);
+
+	if (uEnd - stats_start_ns >= SecondsToNs(GYRO_STATS_PERIOD))
+	{
+		PublishStats();
 	}
 }
 
+/**
+ * Integrates the batch with GYRO_INTEGRATION, each sample on its own timestamp, then
+ * lets the bias filter learn from the batch if the robot was still through it.
+ */
 void ADXRS453Z::UpdateData() {
-	int sensor_data = assemble_sensor_data(data);
-	float rate = ((float) sensor_data) / 80.0;
+	float rate_sum = 0.0;
+	float mean_rate;
+
+	if (!bias_filter.IsStarted())
+	{
+		// calibration just finished, its estimate is as good as the batches it averaged
+
+		int batches = (iLoop > GYRO_BATCH_SAMPLES) ? (iLoop / GYRO_BATCH_SAMPLES) : 1;
+
+		bias_filter.Start(rate_offset, GYRO_BIAS_NOISE * GYRO_BIAS_NOISE / batches, last_sample_ns);
+	}
 
-	current_rate = rate;
-	current_rate -= rate_offset;
-	thisTime = update_timer->Get();
+	for (int i = 0; i < batch_count; i++)
+	{
+		if (i == zero_from)
+		{
+			angle_integrator.Zero();
+		}
+
+		angle_integrator.Add(batch_rate[i] - rate_offset, batch_time_ns[i]);
+		rate_sum += batch_rate[i];
+		last_sample_ns = batch_time_ns[i];
+	}
 
-	accumulated_offset += rate * (thisTime - lastTime);
-	accumulated_angle += current_rate * (thisTime - lastTime);
-	lastTime = thisTime;
-	iLoop++;
+	// the batch's mean is the rate over its span, with the noise of one sample averaged down
+
+	mean_rate = rate_sum / batch_count;
+	still = still_hint.load(std::memory_order_relaxed) && (fabs(mean_rate - rate_offset) < GYRO_STILL_RATE);
+	bias_filter.Add(mean_rate, last_sample_ns, still);
+	rate_offset = bias_filter.GetBias();
+	current_rate = mean_rate - rate_offset;
+	iLoop += batch_count;
 }
 
+///The bias is the mean raw rate since the warm up ended
 void ADXRS453Z::Calibrate() {
-	int sensor_data = assemble_sensor_data(data);
-	float rate = ((float) sensor_data) / 80.0;
+	for (int i = 0; i < batch_count; i++)
+	{
+		offset_integrator.Add(batch_rate[i], batch_time_ns[i]);
+		last_sample_ns = batch_time_ns[i];
+	}
 
-	thisTime = update_timer->Get();
-	accumulated_offset += rate * (thisTime - lastTime);
-	lastTime = thisTime;
-	rate_offset = accumulated_offset
-			/ (calibration_timer->Get() - WARM_UP_PERIOD);
-	iLoop++;
+	if (last_sample_ns > calibration_start_ns)
+	{
+		rate_offset = offset_integrator.GetAngle()
+				/ ((double) (last_sample_ns - calibration_start_ns) / NS_PER_SEC);
+	}
+
+	iLoop += batch_count;
+}
+
+/**
+ * While the robot sits still any change in angle is drift.  Every GYRO_DRIFT_WINDOW of
+ * stillness the change is published as degrees per minute, moving starts a new window.
+ */
+void ADXRS453Z::MeasureDrift() {
+	uint64_t uNow = last_sample_ns;
+
+	if ((drift_start_ns == 0) || (fabs(current_rate) > GYRO_STILL_RATE))
+	{
+		drift_start_ns = uNow;
+		drift_start_angle = angle_integrator.GetAngle();
+	}
+	else if (uNow - drift_start_ns >= SecondsToNs(GYRO_DRIFT_WINDOW))
+	{
+		Telemetry::Set(driftKey, (angle_integrator.GetAngle() - drift_start_angle) * 60.0
+				/ ((double) (uNow - drift_start_ns) / NS_PER_SEC));
+		drift_start_ns = uNow;
+		drift_start_angle = angle_integrator.GetAngle();
+	}
+}
+
+void ADXRS453Z::PublishStats() {
+	uint64_t uNow = GetMonotonicNs();
+
+	Telemetry::Set(sampleRateKey, stats_samples / ((double) (uNow - stats_start_ns) / NS_PER_SEC));
+	Telemetry::Set(transferKey, transfer_time.GetPercentileUs(0.99));
+	Telemetry::Set(latencyKey, latency.GetPercentileUs(0.99));
+	Telemetry::Set(maxLatencyKey, latency.GetMaxUs());
+	Telemetry::Set(biasKey, rate_offset);
+	Telemetry::SetBoolean(stillKey, still);
+	stats_start_ns = uNow;
+	stats_samples = 0;
+}
+
+/**
+ * Copies out the newest snapshot without ever blocking the gyro task.  A Zero() or
+ * Reset() it hasn't applied yet already shows, so Zero() then GetAngle() reads 0.
+ */
+GyroSnapshot ADXRS453Z::GetSnapshot() {
+	GyroSnapshot snapshot;
+	uint32_t uWord;
+	uint32_t uBefore;
+	uint32_t uAfter;
+
+	do
+	{
+		uBefore = snapshot_sequence.load(std::memory_order_acquire);
+
+		if (uBefore & 1)
+		{
+			// the gyro task is writing, it only takes a moment
+			continue;
+		}
+
+		for (int i = 0; i < GYRO_SNAPSHOT_WORDS; i++)
+		{
+			uWord = snapshot_words[i].load(std::memory_order_relaxed);
+			memcpy((char*)&snapshot + i * sizeof(uint32_t), &uWord, sizeof(uint32_t));
+		}
+
+		std::atomic_thread_fence(std::memory_order_acquire);
+		uAfter = snapshot_sequence.load(std::memory_order_relaxed);
+	}
+	while ((uBefore & 1) || (uBefore != uAfter));
+
+	if (snapshot.uResets != reset_requests.load(std::memory_order_acquire))
+	{
+		snapshot.fAngle = 0.0;
+		snapshot.fRate = 0.0;
+		snapshot.fOffset = 0.0;
+		snapshot.uSamples = 0;
+	}
+	else if (snapshot.uZeros != zero_requests.load(std::memory_order_acquire))
+	{
+		snapshot.fAngle = 0.0;
+	}
+
+	return snapshot;
 }
 
 float ADXRS453Z::GetRate() {
-	return current_rate;
+	return GetSnapshot().fRate;
 }
 
 float ADXRS453Z::GetAngle() {
-	return accumulated_angle;
+	return GetSnapshot().fAngle;
 }
 
 float ADXRS453Z::Offset() {
-	return rate_offset;
+	return GetSnapshot().fOffset;
 }
 
+///Asks the gyro task to forget its calibration and start over, safe from any task
 void ADXRS453Z::Reset() {
-	data[0] = 0;
-	data[1] = 0;
-	data[2] = 0;
-	data[3] = 0;
-	current_rate = 0.0;
-	accumulated_angle = 0.0;
-	rate_offset = 0.0;
-	accumulated_offset = 0.0;
-
-	//calibration_timer->Stop();
-	calibration_timer->Reset();
-
-	//update_timer->Stop();
-	update_timer->Reset();
+	reset_requests.fetch_add(1, std::memory_order_release);
 }
 
 //a function to simply zero the gyro rather than reset & calibrate. Added by Taylor Smith
+//Safe from any task, the gyro task zeroes the angle before its next sample.
 void ADXRS453Z::Zero()
 {
-	current_rate = 0.0;
-	accumulated_angle = 0.0;
+	zero_requests.fetch_add(1, std::memory_order_release);
+}
+
+///The drivetrain says whether the robot is sitting still, safe from any task
+void ADXRS453Z::SetStill(bool bStill) {
+	still_hint.store(bStill, std::memory_order_relaxed);
+}
+
+///Gyro task only, carries out the Zero() and Reset() calls made since the last sample
+void ADXRS453Z::ApplyCommands() {
+	uint32_t uResets = reset_requests.load(std::memory_order_acquire);
+	uint32_t uZeros = zero_requests.load(std::memory_order_acquire);
+
+	if (uResets != resets_applied)
+	{
+		data[0] = 0;
+		data[1] = 0;
+		data[2] = 0;
+		data[3] = 0;
+		current_rate = 0.0;
+		rate_offset = 0.0;
+		angle_integrator.Restart();
+		offset_integrator.Restart();
+		bias_filter.Stop();
+		still = false;
+		batch_count = 0;
+		zero_from = -1;
+		iLoop = 0;
+
+		//calibration_timer->Stop();
+		calibration_timer->Reset();
+
+		drift_start_ns = 0;
+		resets_applied = uResets;
+	}
+
+	if (uZeros != zeros_applied)
+	{
+		// samples already in the batch were taken before the zero, UpdateData() zeroes
+		// the angle when it gets to the first one after
+
+		zero_from = batch_count;
+		drift_start_ns = 0; //a zeroed angle is no drift
+		zeros_applied = uZeros;
+	}
+}
+
+///Gyro task only, the single writer of the snapshot
+void ADXRS453Z::PublishSnapshot() {
+	GyroSnapshot snapshot;
+	uint32_t uWord;
+	uint32_t uSeq = snapshot_sequence.load(std::memory_order_relaxed);
+
+	memset(&snapshot, 0, sizeof(snapshot));
+	snapshot.fAngle = angle_integrator.GetAngle();
+	snapshot.fRate = current_rate;
+	snapshot.fOffset = rate_offset;
+	snapshot.uSamples = iLoop;
+	snapshot.uTimeNs = batch_time_ns[batch_count - 1];
+	snapshot.uZeros = zeros_applied;
+	snapshot.uResets = resets_applied;
+
+	snapshot_sequence.store(uSeq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for (int i = 0; i < GYRO_SNAPSHOT_WORDS; i++)
+	{
+		memcpy(&uWord, (const char*)&snapshot + i * sizeof(uint32_t), sizeof(uint32_t));
+		snapshot_words[i].store(uWord, std::memory_order_relaxed);
+	}
+
+	snapshot_sequence.store(uSeq + 2, std::memory_order_release);
 }
 
 short ADXRS453Z::assemble_sensor_data(unsigned char * data) {
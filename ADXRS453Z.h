@@ -5,20 +5,47 @@
 #ifndef ADXRS450GYRO_H_
 #define ADXRS450GYRO_H_
 
+#include <stdint.h>
+#include <atomic>
+
 #include "WPILib.h"
 
+//Robot
+#include "GyroBiasFilter.h"
+#include "GyroIntegrator.h"
+#include "LatencyHistogram.h"
+#include "RobotParams.h"
+#include "Telemetry.h"
+
 const float WARM_UP_PERIOD = 5.0;  //seconds
 const float CALIBRATE_PERIOD = 15.0; //seconds
 
-int ADXRS453ZUpdateFunction(int pointer_val);
+int ADXRS453ZUpdateFunction(intptr_t pointer_val);
+
+///What the gyro task last published, all from the same batch
+struct GyroSnapshot {
+	double fAngle;			//!< degrees since the last zero
+	uint64_t uTimeNs;		//!< monotonic time of the newest sample
+	float fRate;			//!< deg/s, bias removed
+	float fOffset;			//!< deg/s of bias being removed
+	uint32_t uSamples;		//!< samples integrated since the last reset
+	uint32_t uZeros;		//!< Zero() calls applied
+	uint32_t uResets;		//!< Reset() calls applied
+};
+
+const int GYRO_SNAPSHOT_WORDS = sizeof(GyroSnapshot) / sizeof(uint32_t);
+
+static_assert(sizeof(GyroSnapshot) % sizeof(uint32_t) == 0, "snapshots copy whole words");
 
 class ADXRS453Z {
 	public:
 		ADXRS453Z();
+		GyroSnapshot GetSnapshot();
 		float GetRate();
 		float GetAngle();
 		void Reset();
 		void Zero(); //added by Taylor Smith
+		void SetStill(bool bStill);
 		void Update();
 		float Offset();
 		void Start();
@@ -26,6 +53,10 @@ class ADXRS453Z {
 	private:
 		void UpdateData();
 		void Calibrate();
+		void MeasureDrift();
+		void PublishStats();
+		void ApplyCommands();
+		void PublishSnapshot();
 		static void check_parity(unsigned char * command); //gyro requires odd parity for command
 		static int bits(unsigned char val); //returns number of on bits in a byte (helper for parity check)
 		static short assemble_sensor_data(unsigned char * data); //takes the sensor data from the data array and puts it into an int
@@ -34,12 +65,15 @@ class ADXRS453Z {
 		static const unsigned char FIRST_BYTE_DATA = 0x3; //mask to find sensor data bits on first byte: X X X X X X D D
 		static const unsigned char THIRD_BYTE_DATA = 0xFC; //mask to find sensor data bits on third byte: D D D D D D X X
 		static const unsigned char READ_COMMAND = 0x20; //0010 0000 for first byte
-		float accumulated_angle;
-		Timer * update_timer;
+		GyroIntegrator angle_integrator;	//bias removed, since the last zero
+		GyroIntegrator offset_integrator;	//raw, over the calibration period
+		GyroBiasFilter bias_filter;			//takes over from calibration
+		std::atomic<bool> still_hint;		//set by the drivetrain
+		bool still;							//the last batch taught the bias filter
+		uint64_t calibration_start_ns;
 		Timer * calibration_timer;
 		float current_rate;
-		float accumulated_offset;
-		float rate_offset;
+		double rate_offset;
 		unsigned char command[4];
 		unsigned char data[4];
 		SPI * spi;
@@ -51,8 +85,36 @@ class ADXRS453Z {
 		char sensor_output_3[9];
 		char sensor_output_4[9];
 
-		float lastTime;
-		float thisTime;
+		//samples read since the last batch was integrated, each timestamped when it was read
+		float batch_rate[GYRO_BATCH_SAMPLES];
+		uint64_t batch_time_ns[GYRO_BATCH_SAMPLES];
+		int batch_count;
+		int zero_from;					//first sample in the batch after a Zero(), -1 if none
+		uint64_t last_sample_ns;
 		int iLoop;
+
+		//any task asks for a zero or reset by bumping these, the gyro task applies them
+		std::atomic<uint32_t> zero_requests;
+		std::atomic<uint32_t> reset_requests;
+		uint32_t zeros_applied;
+		uint32_t resets_applied;
+
+		//the snapshot is a seqlock, odd while the gyro task is writing it
+		std::atomic<uint32_t> snapshot_sequence;
+		std::atomic<uint32_t> snapshot_words[GYRO_SNAPSHOT_WORDS];
+
+		LatencyHistogram transfer_time;	//one SPI transaction
+		LatencyHistogram latency;		//oldest sample in a batch to its angle being updated
+		uint64_t drift_start_ns;		//0 until the robot is still
+		double drift_start_angle;
+		uint64_t stats_start_ns;
+		int stats_samples;
+		TelemetryKey sampleRateKey;
+		TelemetryKey transferKey;
+		TelemetryKey latencyKey;
+		TelemetryKey maxLatencyKey;
+		TelemetryKey driftKey;
+		TelemetryKey biasKey;
+		TelemetryKey stillKey;
 };
 #endif /* ADXRS450GYRO_H_ */
@@ -20,8 +20,8 @@
 using namespace std;
 
 const char *szTokens[] = {
-		"START"
-		"FINISH"
+		"START",
+		"FINISH",
 		"MODE",
 		"DEBUG",
 		"MESSAGE",
@@ -36,6 +36,8 @@ const char *szTokens[] = {
 		"STARTDRIVEFWD",	//!<(drive speed)
 		"STARTDRIVEBCK",	//!<(drive speed)
 		"STOPDRIVE",
+		"ASYNC",			//!<(any command that needs a response)
+		"SYNC",
 		"NOP" };
 //TODO: add START and FINISH, which send messages to all components
 // (Begin and End are doing this now, but they shouldn't)
@@ -92,13 +94,6 @@ bool Autonomous::Evaluate(std::string rStatement) {
 		return (true);
 	}
 
-	// if we are paused wait here before executing a real command
-
-	while(bPauseAutoMode)
-	{
-		Wait(0.02);
-	}
-
 	// execute the proper command
 
 	if(iAutoDebugMode)
@@ -215,7 +210,7 @@ bool Autonomous::Evaluate(std::string rStatement) {
 			Message.params.autonomous.driveSpeed = atof(pToken);
 
 			Message.command = COMMAND_DRIVETRAIN_DRIVE_STRAIGHT;//simply drives forward
-			CommandNoResponse(DRIVETRAIN_QUEUE);
+			CommandNoResponse(ENDPOINT_DRIVETRAIN);
 		}
 
 		break;
@@ -235,13 +230,27 @@ bool Autonomous::Evaluate(std::string rStatement) {
 			Message.params.autonomous.driveSpeed = atof(pToken);
 
 			Message.command = COMMAND_DRIVETRAIN_DRIVE_STRAIGHT;	//simply drives back
-			CommandNoResponse(DRIVETRAIN_QUEUE);
+			CommandNoResponse(ENDPOINT_DRIVETRAIN);
 		}
 		break;
 
 	case AUTO_TOKEN_STOP_DRIVE:
 		Message.command = COMMAND_DRIVETRAIN_STOP;
-		CommandNoResponse(DRIVETRAIN_QUEUE);
+		CommandNoResponse(ENDPOINT_DRIVETRAIN);
+		break;
+
+	case AUTO_TOKEN_ASYNC:
+		// evaluate the rest of the line but don't wait for its response
+
+		bAsyncLine = true;
+		bReturn = Evaluate(pCurrLinePos);
+		bAsyncLine = false;
+		rStatus.append("async");
+		break;
+
+	case AUTO_TOKEN_SYNC:
+		bSyncPending = true;
+		rStatus.append("sync");
 		break;
 
 	default:
@@ -29,6 +29,8 @@ typedef enum AUTO_COMMAND_TOKENS
 	AUTO_TOKEN_START_DRIVE_FWD,
 	AUTO_TOKEN_START_DRIVE_BCK,
 	AUTO_TOKEN_STOP_DRIVE,
+	AUTO_TOKEN_ASYNC,				//!<_	run the rest of the line without waiting for its response
+	AUTO_TOKEN_SYNC,				//!<_	wait for every ASYNC command to finish
 	
 	AUTO_TOKEN_LAST
 } AUTO_COMMAND_TOKENS;
@@ -18,7 +18,9 @@
 
 //Robot
 #include "ComponentBase.h"
+#include "MessageEndpoint.h"
 #include "RobotParams.h"
+#include "RobotTime.h"
 #include "AutoParser.h"
 
 using namespace std;
@@ -26,155 +28,123 @@ using namespace std;
 extern "C" {
 }
 
-bool Autonomous::CommandResponse(const char *szQueueName) {
-	int iPipeXmt;
-	bool bReturn = true;
+bool Autonomous::CommandResponse(MessageEndpointId endpoint) {
+	int iHandle;
 
-	iPipeXmt = open(szQueueName, O_WRONLY);
-	wpi_assert(iPipeXmt > 0);
+	// reserve the response before sending so a quick reply can't beat us to it
 
-	Message.replyQ = AUTONOMOUS_QUEUE;
-	write(iPipeXmt, (char*) &Message, sizeof(RobotMessage));
-	close(iPipeXmt);
+	iHandle = responses.Expect(endpoint, &Message.header.uCorrelation);
 
-	bReceivedCommandResponse = false;
-
-	while (!bReceivedCommandResponse)
+	if(iHandle < 0)
 	{
-		//purposefully empty
+		SmartDashboard::PutString("Auto Status","TOO MANY RESPONSES!");
+		PRINTAUTOERROR;
+		return (false);
 	}
 
-	if(iAutoDebugMode)
-	{
-		printf("%0.3lf Response received\n", pDebugTimer->Get());
-	}
+	MessageEndpoint::Resolve(endpoint)->Send(&Message);
+	Message.header.uCorrelation = 0;
 
-	if (ReceivedCommand == COMMAND_AUTONOMOUS_RESPONSE_OK)
-	{
-		SmartDashboard::PutString("Auto Status","auto ok");
-		bReturn = true;
-	}
-	else if (ReceivedCommand == COMMAND_AUTONOMOUS_RESPONSE_ERROR)
-	{
-		SmartDashboard::PutString("Auto Status","EARLY DEATH!");
-		PRINTAUTOERROR;
-		bReturn = false;
-	}
+	// StepScript reports the response when it comes
 
-	return bReturn;
+	GetCommandWait()->handles.push_back(iHandle);
+	return (true);
 }
 
 
 //UNTESTED
-//USAGE: MultiCommandResponse({DRIVETRAIN_QUEUE, CONVEYOR_QUEUE}, {COMMAND_DRIVETRAIN_STRAIGHT, COMMAND_CONVEYOR_SEEK_TOTE});
-bool Autonomous::MultiCommandResponse(vector<char*> szQueueNames, vector<MessageCommand> commands) {
+//USAGE: MultiCommandResponse({ENDPOINT_DRIVETRAIN, ENDPOINT_CONVEYOR}, {COMMAND_DRIVETRAIN_STRAIGHT, COMMAND_CONVEYOR_SEEK_TOTE});
+//bWaitAll false finishes as soon as the first component answers, the others are abandoned
+bool Autonomous::MultiCommandResponse(vector<MessageEndpointId> endpoints, vector<MessageCommand> commands,
+		bool bWaitAll) {
 	//wait for several commands at once
 	//check that queue list is as long as command list
-	if(szQueueNames.size() != commands.size())
+	if(endpoints.size() != commands.size())
 	{
 		SmartDashboard::PutString("Auto Status","MULTICOMMAND error!");
 		return false;
 	}
-	bool bReturn = true;
-	int iPipeXmt;
-	uResponseCount = 0;
-	//vector<int> iPipesXmt = new vector<int>();
+	AutoWait *pWait;
+	vector<int> handles;
 	//send messages to each component
-	for (unsigned int i = 0; i < szQueueNames.size(); i++)
+	for (unsigned int i = 0; i < endpoints.size(); i++)
 	{
-		iPipeXmt = open(szQueueNames[i], O_WRONLY);
-		wpi_assert(iPipeXmt > 0);
-
-		Message.replyQ = AUTONOMOUS_QUEUE;
-		Message.command = commands[i];
-		write(iPipeXmt, (char*) &Message, sizeof(RobotMessage));
-		close(iPipeXmt);
-	}
+		int iHandle = responses.Expect(endpoints[i], &Message.header.uCorrelation);
 
-	bReceivedCommandResponse = false;
-
-	while (uResponseCount < szQueueNames.size())
-	{
-		while (!bReceivedCommandResponse)
+		if(iHandle < 0)
 		{
-			//purposefully empty
+			for(unsigned int j = 0; j < handles.size(); j++)
+			{
+				responses.Cancel(handles[j]);
+			}
+
+			SmartDashboard::PutString("Auto Status","TOO MANY RESPONSES!");
+			PRINTAUTOERROR;
+			return false;
 		}
 
-		if(iAutoDebugMode)
-		{
-			printf("%0.3lf Response received\n", pDebugTimer->Get());
-		}
-
-		if (ReceivedCommand == COMMAND_AUTONOMOUS_RESPONSE_OK)
-		{
-			SmartDashboard::PutString("Auto Status", "auto ok");
-			bReturn = true;
-		}
-		else if (ReceivedCommand == COMMAND_AUTONOMOUS_RESPONSE_ERROR)
-		{
-			SmartDashboard::PutString("Auto Status", "EARLY DEATH!");
-			bReturn = false;
-		}
+		handles.push_back(iHandle);
+		Message.command = commands[i];
+		MessageEndpoint::Resolve(endpoints[i])->Send(&Message);
 	}
-	return bReturn;
-}
 
-bool Autonomous::CommandNoResponse(const char *szQueueName) {
-	int iPipeXmt;
+	Message.header.uCorrelation = 0;
 
-	iPipeXmt = open(szQueueName, O_WRONLY);
-	wpi_assert(iPipeXmt > 0);
+	pWait = GetCommandWait();
+	pWait->handles = handles;
+	pWait->bWaitAll = bWaitAll;
+	return true;
+}
 
-	write(iPipeXmt, (char*) &Message, sizeof(RobotMessage));
-	close(iPipeXmt);
+bool Autonomous::CommandNoResponse(MessageEndpointId endpoint) {
+	MessageEndpoint::Resolve(endpoint)->Send(&Message);
 	return (true);
 }
 
 void Autonomous::Delay(float delayTime)
 {
-	//breaks the delay into little bits to prevent issues in the event of disabling
-	for (double fWait = 0.0; fWait < delayTime; fWait += 0.01)
-	{
-		// if we are paused break the delay into pieces
-
-		while (bPauseAutoMode)
-		{
-			Wait(0.02);
-		}
+	// StepScript moves on to the next line once this has passed, or at once after an
+	// ASYNC one, which a later SYNC waits for; pauses don't count
 
-		Wait(0.01);
+	if(delayTime < 0.0)
+	{
+		delayTime = 0.0;
 	}
+
+	GetCommandWait()->uResumeNs = GetMonotonicNs() + SecondsToNs(delayTime);
 }
 
 bool Autonomous::Start()
 {
 	//TODO write Autonomous::Start()
+	return(true);
 }
 
 bool Autonomous::Finish()
 {
 	//TODO write Autonomous::Finish()
+	return(true);
 }
 
 bool Autonomous::Begin(char *pCurrLinePos)
 {
 	//tell all the components who may need to know that auto is beginning
 	Message.command = COMMAND_AUTONOMOUS_RUN;
-	return (CommandNoResponse(DRIVETRAIN_QUEUE));
+	return (CommandNoResponse(ENDPOINT_DRIVETRAIN));
 }
 
 bool Autonomous::End(char *pCurrLinePos)
 {
 	//tell all the components who may need to know that auto is beginning
 	Message.command = COMMAND_AUTONOMOUS_COMPLETE;
-	CommandNoResponse(DRIVETRAIN_QUEUE);
+	CommandNoResponse(ENDPOINT_DRIVETRAIN);
 	return (true);
 }
 
 bool Autonomous::Stop(char *pCurrLinePos) {
 	//tell those who need to know that the autonomous behavior is over - reset variables
 	Message.command = COMMAND_DRIVETRAIN_STOP;
-	return (CommandNoResponse(DRIVETRAIN_QUEUE));
+	return (CommandNoResponse(ENDPOINT_DRIVETRAIN));
 }
 
 bool Autonomous::Move(char *pCurrLinePos) {
@@ -199,7 +169,7 @@ bool Autonomous::Move(char *pCurrLinePos) {
 	Message.params.tankDrive.left = fLeft;
 	Message.params.tankDrive.right = fRight;
 
-	return (CommandNoResponse(DRIVETRAIN_QUEUE));
+	return (CommandNoResponse(ENDPOINT_DRIVETRAIN));
 }
 
 bool Autonomous::MeasuredMove(char *pCurrLinePos) {
@@ -236,7 +206,7 @@ bool Autonomous::MeasuredMove(char *pCurrLinePos) {
 	Message.params.autonomous.driveSpeed = fSpeed;
 	Message.params.autonomous.driveDistance = fDistance;
 
-	return (CommandResponse(DRIVETRAIN_QUEUE));
+	return (CommandResponse(ENDPOINT_DRIVETRAIN));
 }
 
 bool Autonomous::Straight(char *pCurrLinePos) {
@@ -271,7 +241,7 @@ bool Autonomous::Straight(char *pCurrLinePos) {
 	Message.command = COMMAND_DRIVETRAIN_DRIVE_STRAIGHT;
 	Message.params.autonomous.driveSpeed = fSpeed;
 	Message.params.autonomous.timeout = fTime;
-	return (CommandNoResponse(DRIVETRAIN_QUEUE));
+	return (CommandResponse(ENDPOINT_DRIVETRAIN));
 }
 
 bool Autonomous::TimedMove(char *pCurrLinePos) {
@@ -294,7 +264,7 @@ bool Autonomous::TimedMove(char *pCurrLinePos) {
 	 Message.params.timedDrive.speed = fSpeed;
 	 Message.params.timedDrive.time = fTime;
 
-	 return(CommandResponse(DRIVETRAIN_QUEUE));
+	 return(CommandResponse(ENDPOINT_DRIVETRAIN));
 	 */
 	return false;
 }
@@ -329,5 +299,5 @@ bool Autonomous::Turn(char *pCurrLinePos) {
 	Message.command = COMMAND_DRIVETRAIN_TURN;
 	Message.params.autonomous.turnAngle = fAngle;
 	Message.params.autonomous.timeout = fTimeout;
-	return (CommandNoResponse(DRIVETRAIN_QUEUE));
+	return (CommandResponse(ENDPOINT_DRIVETRAIN));
 }
\ No newline at end of file
@@ -1,33 +1,63 @@
 /** \file
  * The AutonomousBase component class handles basic autonomous functionality.
+ *
+ * The script runs on the Autonomous component's own task, a few lines at a time.  A
+ * line that has to wait (a DELAY, or a command that needs a response) arms the
+ * script's AutoWait and returns; each tick or response message afterwards checks the
+ * wait and carries on with the next line once it is over.  Commands started with
+ * ASYNC get an AutoWait of their own and finish in the background while the script
+ * moves on, so drivetrain and mechanism actions can overlap; SYNC waits for all of
+ * them.  Pausing simply stops the script being stepped, and pushes every deadline
+ * back by as long as the pause lasted when it resumes.
  */
 
 #ifndef AUTONOMOUS_BASE_H
 #define AUTONOMOUS_BASE_H
 
 //Robot
+#include <stdint.h>
 #include <string>
+#include <atomic>
+#include <vector>
 
 #include "WPILib.h"
 
 #include "ComponentBase.h" //For the ComponentBase class
 #include "RobotParams.h" //For various robot parameters
+#include "ResponseTracker.h" //For waiting on command responses
 
-#If you have more than this many lines in your script, THEY WILL NOT RUN! Change if needed.
+//If you have more than this many lines in your script, THEY WILL NOT RUN! Change if needed.
 const int AUTONOMOUS_SCRIPT_LINES = 150;
 const int AUTONOMOUS_CHECKLIST_LINES = 150;
-const char* const AUTONOMOUS_SCRIPT_FILEPATH = "/home/lvuser/RhsScript.txt";
+const char* const AUTONOMOUS_SCRIPT_FILEPATH = ROBOT_HOME "RhsScript.txt";
 
 //from 2014
 const float MAX_VELOCITY_PARAM = 1.0;
 const float MAX_DISTANCE_PARAM = 100.0;
 
+///longest we will wait for a component to answer a command, the whole autonomous period
+const float AUTONOMOUS_RESPONSE_TIMEOUT = 15.0;
+
+///how often we look for a new script file while no script is running
+const float AUTONOMOUS_SCRIPT_RELOAD_PERIOD = 1.0;
+
+///What the script, or one ASYNC command, is waiting for before it is finished
+struct AutoWait {
+	bool bActive;					//!< something was started and has not been reported yet
+	int iLine;						//!< script line that started it
+	std::vector<int> handles;		//!< responses still to come
+	bool bWaitAll;					//!< false finishes on the first response
+	bool bFailed;					//!< a component answered with an error
+	bool bTimedOut;
+	uint64_t uResumeNs;				//!< end of a DELAY, 0 if none
+	uint64_t uTimeoutNs;			//!< when we give up on the responses
+};
+
 class Autonomous : public ComponentBase
 {
 public:
 	Autonomous();
 	~Autonomous();
-	void DoScript();
 
 	static void *StartTask(void *pThis)
 	{
@@ -35,27 +65,27 @@ public:
 		return(NULL);
 	}
 
-	static void *StartScript(void *pThis)
-	{
-		((Autonomous *)pThis)->DoScript();
-		return(NULL);
-	}
-
 protected:
 	bool Evaluate(std::string statement);	//Evaluates an autonomous script statement
 	RobotMessage Message;
-	bool bScriptLoaded; //not yet in use
-	bool bInAutoMode;
+	bool bScriptLoaded; //a script has been read and is ready to run
+	bool bInAutoMode;	//a script is running, possibly paused
 	bool bPauseAutoMode;
+	bool bAsyncLine;	//the statement being evaluated was prefixed with ASYNC
 
 private:
 	std::string script[AUTONOMOUS_SCRIPT_LINES];	//Autonomous script
+	std::string stagedScript[AUTONOMOUS_SCRIPT_LINES];	//Filled by a background worker, adopted between runs
+	std::atomic<int> iStagedResult;		//0 nothing new, 1 stagedScript loaded, -1 no script file
+	std::atomic<bool> bScriptLoadQueued;
 	int lineNumber;
 	int iAutoDebugMode;
-	Task *pScript;
-	bool bReceivedCommandResponse;
-	unsigned int uResponseCount;
-	MessageCommand ReceivedCommand;
+	ResponseTracker responses;
+	AutoWait scriptWait;			//what the next script line waits for
+	std::vector<AutoWait> asyncWaits;	//ASYNC commands still in flight
+	bool bSyncPending;				//SYNC: the next line waits until asyncWaits is empty
+	uint64_t uPausedNs;				//when the current pause began
+	uint64_t uNextReloadNs;			//when we next look for a new script file
 
 	void Delay(float);
 	bool Start();
@@ -69,14 +99,34 @@ private:
 	bool Turn(char *);
 	bool Straight(char *);
 
-	bool CommandResponse(const char *szQueueName);
-	bool CommandNoResponse(const char *szQueueName);
-	bool MultiCommandResponse(vector<char*> szQueueNames, vector<MessageCommand> commands);
+	void StepScript();
+	void StartScript();
+	void FinishScript();
+	void ResumeScript();
+	void ArmWait(AutoWait *pWait);
+	bool CheckWait(AutoWait *pWait, uint64_t uNow);
+	void ReportWait(AutoWait *pWait);
+	AutoWait *GetCommandWait();
+
+	bool CommandResponse(MessageEndpointId endpoint);
+	bool CommandNoResponse(MessageEndpointId endpoint);
+	bool MultiCommandResponse(vector<MessageEndpointId> endpoints, vector<MessageCommand> commands,
+			bool bWaitAll = true);
 
 	void Init();
 	void OnStateChange();
 	void Run();
+	void SmartDashboardUpdate();
 	bool LoadScriptFile();
+	bool AdoptLoadedScript();
+
+	static void LoadScriptJob(void *pThis)
+	{
+		Autonomous *pAuto = (Autonomous *)pThis;
+
+		pAuto->iStagedResult.store(pAuto->LoadScriptFile() ? 1 : -1);
+		pAuto->bScriptLoadQueued.store(false);
+	}
 };
 
 #endif //AUTONOMOUS_BASE_H
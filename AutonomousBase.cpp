@@ -12,33 +12,55 @@
 
 #include "ComponentBase.h"
 #include "RobotParams.h"
+#include "RobotTime.h"
+#include "TaskScheduler.h"
+#include "FlightRecorder.h"
 
 using namespace std;
 
 Autonomous::Autonomous()
-: ComponentBase(AUTONOMOUS_TASKNAME, AUTONOMOUS_QUEUE, AUTONOMOUS_PRIORITY)
+: ComponentBase(AUTONOMOUS_TASKNAME, ENDPOINT_AUTONOMOUS, AUTONOMOUS_PRIORITY,
+		AUTONOMOUS_TRANSPORT, AUTONOMOUS_TICK_PERIOD, AUTONOMOUS_DEADLINE)
 {
 	lineNumber = 0;
 	bInAutoMode = false;
+	bPauseAutoMode = false;
+	bAsyncLine = false;
+	bScriptLoaded = false;
+	bSyncPending = false;
 	iAutoDebugMode = 0;
-	bReceivedCommandResponse = false;
-	ReceivedCommand = COMMAND_UNKNOWN;
+	uPausedNs = 0;
+	uNextReloadNs = 0;
+	scriptWait.bActive = false;
+	scriptWait.uResumeNs = 0;
+	scriptWait.uTimeoutNs = 0;
+	iStagedResult.store(0);
+	bScriptLoadQueued.store(false);
 
-	pTask = new Task(AUTONOMOUS_TASKNAME, (FUNCPTR) &Autonomous::StartTask,
-		AUTONOMOUS_PRIORITY, AUTONOMOUS_STACKSIZE);
-	wpi_assert(pTask);
-	pTask->Start((int)this);
+	// everything autonomous sends is answered back to our own queue
+	Message.header.uSource = ENDPOINT_AUTONOMOUS;
+	Message.header.uReply = ENDPOINT_AUTONOMOUS;
+	Message.header.uFlags = 0;
+	Message.header.uCorrelation = 0;
 
-	pScript = new Task(AUTOEXEC_TASKNAME, (FUNCPTR) &Autonomous::StartScript,
-			AUTOEXEC_PRIORITY, AUTOEXEC_STACKSIZE);
-	wpi_assert(pScript);
-	pScript->Start((int)this);
+	// with the executor enabled ComponentBase has already registered us there
+
+	if(!COMPONENT_EXECUTOR_ENABLED)
+	{
+		pTask = new Task(AUTONOMOUS_TASKNAME, (FUNCPTR) &Autonomous::StartTask,
+			AUTONOMOUS_PRIORITY, AUTONOMOUS_STACKSIZE);
+		wpi_assert(pTask);
+		pTask->Start((intptr_t)this);
+	}
+
+	SmartDashboard::PutString("Script Line", "<NOT RUNNING>");
+	SmartDashboard::PutString("Auto Status", "Ready to go");
+	SmartDashboard::PutBoolean("Script File Loaded", false);
 }
 
 Autonomous::~Autonomous()	//Destructor
 {
 	delete(pTask);
-	delete(pScript);
 }
 
 void Autonomous::Init()	//Initializes the autonomous component
@@ -52,20 +74,33 @@ void Autonomous::OnStateChange()	//Handles state changes
 
 	if(localMessage.command == COMMAND_ROBOT_STATE_AUTONOMOUS)
 	{
-		bPauseAutoMode = false;
-		bInAutoMode = true;
 		pDebugTimer->Reset();
+
+		if(!bInAutoMode)
+		{
+			StartScript();
+		}
+		else if(bPauseAutoMode)
+		{
+			ResumeScript();
+		}
 	}
-	else if(localMessage.command == COMMAND_ROBOT_STATE_TELEOPERATED)
-	{
-		bPauseAutoMode = true;
-	}
-	else if(localMessage.command == COMMAND_ROBOT_STATE_DISABLED)
+	else if((localMessage.command == COMMAND_ROBOT_STATE_TELEOPERATED) ||
+			(localMessage.command == COMMAND_ROBOT_STATE_DISABLED))
 	{
-		bPauseAutoMode = true;
+		if(!bPauseAutoMode)
+		{
+			bPauseAutoMode = true;
+			uPausedNs = GetMonotonicNs();
+		}
 	}
 }
 
+///Autonomous puts its status up as it changes
+void Autonomous::SmartDashboardUpdate()
+{
+}
+
 void Autonomous::Run()
 {
 	switch(localMessage.command)
@@ -77,22 +112,26 @@ void Autonomous::Run()
 			break;
 
 		case COMMAND_AUTONOMOUS_RESPONSE_OK:
-			uResponseCount++;
-			bReceivedCommandResponse = true;
-			ReceivedCommand = COMMAND_AUTONOMOUS_RESPONSE_OK;
-			break;
-
 		case COMMAND_AUTONOMOUS_RESPONSE_ERROR:
-			uResponseCount++;
-			bReceivedCommandResponse = true;
-			ReceivedCommand = COMMAND_AUTONOMOUS_RESPONSE_ERROR;
+			// a response nobody is waiting for is late, it must not complete anything else
+
+			if(!responses.Complete(&localMessage) && iAutoDebugMode)
+			{
+				printf("%0.3lf Late response %u from endpoint %u dropped\n", pDebugTimer->Get(),
+						localMessage.header.uCorrelation, localMessage.header.uSource);
+			}
 			break;
 
 		default:
 			break;
 	}
+
+	// every tick and every response is a chance for the script to move on
+
+	StepScript();
 }
 
+///Runs on a background worker, reads the script into stagedScript
 bool Autonomous::LoadScriptFile()
 {
 	bool bReturn = true;
@@ -106,12 +145,12 @@ bool Autonomous::LoadScriptFile()
 		{
 			if(!scriptStream.eof())
 			{
-				getline(scriptStream, script[i]);
+				getline(scriptStream, stagedScript[i]);
 				//cout << script[i] << endl;
 			}
 			else
 			{
-				script[i].clear();
+				stagedScript[i].clear();
 			}
 		}
 
@@ -127,71 +166,267 @@ bool Autonomous::LoadScriptFile()
 	return(bReturn);
 }
 
-void Autonomous::DoScript()
+/**
+ * Takes the script a background worker read last time, if there is one, and asks for
+ * the file to be read again.  Returns true if we have a script to run.
+ */
+bool Autonomous::AdoptLoadedScript()
 {
-	//int loadAttemptTally = 0; //for debugging
-	SmartDashboard::PutString("Script Line", "DoScript started");
-	SmartDashboard::PutString("Auto Status", "Ready to go");
-	SmartDashboard::PutBoolean("Script File Loaded", false);
-	//printf("DoScript\n");
-	
-	while(true)
+	int iResult = iStagedResult.exchange(0);
+
+	if(iResult > 0)
 	{
-		lineNumber = 0;
+		for(int i = 0; i < AUTONOMOUS_SCRIPT_LINES; ++i)
+		{
+			script[i].swap(stagedScript[i]);
+		}
+
+		bScriptLoaded = true;
+	}
+	else if(iResult < 0)
+	{
+		bScriptLoaded = false;
+	}
+
+	if(!bScriptLoadQueued.exchange(true))
+	{
+		TaskScheduler::GetInstance()->Submit(&Autonomous::LoadScriptJob, this);
+	}
+
+	return(bScriptLoaded);
+}
+
+/**
+ * Runs script lines until one has to wait or the script ends.  Called from Run() on
+ * every tick and message, it never blocks.
+ */
+void Autonomous::StepScript()
+{
+	uint64_t uNow = GetMonotonicNs();
+
+	// between runs keep picking up edits to the script file
+
+	if((!bInAutoMode || !bScriptLoaded) && (uNow >= uNextReloadNs))
+	{
+		uNextReloadNs = uNow + SecondsToNs(AUTONOMOUS_SCRIPT_RELOAD_PERIOD);
+		SmartDashboard::PutBoolean("Script File Loaded", AdoptLoadedScript());
+	}
+
+	if(!bInAutoMode || !bScriptLoaded || bPauseAutoMode)
+	{
+		return;
+	}
+
+	// ASYNC commands finish whatever line the script is on
+
+	for(unsigned i = 0; i < asyncWaits.size(); )
+	{
+		if(CheckWait(&asyncWaits[i], uNow))
+		{
+			asyncWaits.erase(asyncWaits.begin() + i);
+		}
+		else
+		{
+			i++;
+		}
+	}
+
+	while(bInAutoMode)
+	{
+		if(!CheckWait(&scriptWait, uNow) || (bSyncPending && !asyncWaits.empty()))
+		{
+			return;
+		}
+
+		bSyncPending = false;
+
+		if(lineNumber >= AUTONOMOUS_SCRIPT_LINES)
+		{
+			FinishScript();
+			break;
+		}
+
 		SmartDashboard::PutNumber("Script Line Number", lineNumber);
 
-		//TODO: LoadScriptFile is called every stinking time we want to check load status! Does this eat time?
-		//We want to load the file while disabled - this allows us to load new scripts
-		if(LoadScriptFile() == false)
+		// can we have empty lines?  at the end I guess
+
+		if(script[lineNumber].empty() == false)
 		{
-			// wait a little and try again, really only useful if when practicing
+			SmartDashboard::PutString("Script Line", script[lineNumber].c_str());
 
-			SmartDashboard::PutBoolean("Script File Loaded", false);
-			Wait(1.0);
+			if(Evaluate(script[lineNumber]))
+			{
+				FinishScript();
+				break;
+			}
 		}
-		else
+
+		lineNumber++;
+	}
+}
+
+///Runs the script from the top, if we have one
+void Autonomous::StartScript()
+{
+	AdoptLoadedScript();
+	SmartDashboard::PutBoolean("Script File Loaded", bScriptLoaded);
+
+	lineNumber = 0;
+	bInAutoMode = true;
+	bPauseAutoMode = false;
+	bSyncPending = false;
+	scriptWait.bActive = false;
+	scriptWait.handles.clear();
+	scriptWait.uResumeNs = 0;
+}
+
+///The script ran off its end or hit END, ASYNC commands still in flight are left to finish
+void Autonomous::FinishScript()
+{
+	for(unsigned i = 0; i < scriptWait.handles.size(); i++)
+	{
+		responses.Cancel(scriptWait.handles[i]);
+	}
+
+	scriptWait.handles.clear();
+	scriptWait.bActive = false;
+	bInAutoMode = false;
+	SmartDashboard::PutString("Script Line", "<NOT RUNNING>");
+}
+
+///Carries on after a pause, the pause doesn't count against delays or response timeouts
+void Autonomous::ResumeScript()
+{
+	uint64_t uPaused = GetMonotonicNs() - uPausedNs;
+
+	if(scriptWait.uResumeNs != 0)
+	{
+		scriptWait.uResumeNs += uPaused;
+	}
+
+	scriptWait.uTimeoutNs += uPaused;
+
+	for(unsigned i = 0; i < asyncWaits.size(); i++)
+	{
+		if(asyncWaits[i].uResumeNs != 0)
+		{
+			asyncWaits[i].uResumeNs += uPaused;
+		}
+
+		asyncWaits[i].uTimeoutNs += uPaused;
+	}
+
+	bPauseAutoMode = false;
+}
+
+///Starts a new wait for the current line
+void Autonomous::ArmWait(AutoWait *pWait)
+{
+	pWait->bActive = true;
+	pWait->iLine = lineNumber;
+	pWait->handles.clear();
+	pWait->bWaitAll = true;
+	pWait->bFailed = false;
+	pWait->bTimedOut = false;
+	pWait->uResumeNs = 0;
+	pWait->uTimeoutNs = GetMonotonicNs() + SecondsToNs(AUTONOMOUS_RESPONSE_TIMEOUT);
+}
+
+///Where a command on the current line waits for its response
+AutoWait *Autonomous::GetCommandWait()
+{
+	AutoWait *pWait = &scriptWait;
+
+	if(bAsyncLine)
+	{
+		asyncWaits.push_back(AutoWait());
+		pWait = &asyncWaits.back();
+	}
+
+	ArmWait(pWait);
+	return(pWait);
+}
+
+///Collects responses and returns true once nothing is left to wait for
+bool Autonomous::CheckWait(AutoWait *pWait, uint64_t uNow)
+{
+	MessageCommand response;
+
+	if(!pWait->bActive)
+	{
+		return(true);
+	}
+
+	for(unsigned i = 0; i < pWait->handles.size(); )
+	{
+		if(!responses.Poll(pWait->handles[i], &response))
 		{
-			SmartDashboard::PutBoolean("Script File Loaded", true);
+			i++;
+			continue;
+		}
 
-			// if there is a script we will execute it some heck or high water!
+		if(response != COMMAND_AUTONOMOUS_RESPONSE_OK)
+		{
+			pWait->bFailed = true;
+		}
+
+		pWait->handles.erase(pWait->handles.begin() + i);
+
+		if(!pWait->bWaitAll)
+		{
+			// the first answer decides, nobody is listening for the others
 
-			while (bInAutoMode)
+			for(unsigned j = 0; j < pWait->handles.size(); j++)
 			{
-				SmartDashboard::PutNumber("Script Line Number", lineNumber);
-
-				if (!bPauseAutoMode)
-				{
-					if (lineNumber < AUTONOMOUS_SCRIPT_LINES)
-					{
-						// can we have empty lines?  at the end I guess
-
-						if (script[lineNumber].empty() == false)
-						{
-							// handle pausing in the Evaluate method
-
-							SmartDashboard::PutString("Script Line",
-									script[lineNumber].c_str());
-
-							if (Evaluate(script[lineNumber]))
-							{
-								SmartDashboard::PutString("Script Line", "<NOT RUNNING>");
-								break;
-							}
-						}
-
-						lineNumber++;
-					}
-					else
-					{
-						break;
-					}
-				}
+				responses.Cancel(pWait->handles[j]);
 			}
 
-			bInAutoMode = false;
-			Wait(0.1);
+			pWait->handles.clear();
 		}
 	}
 
-	bInAutoMode = false;
+	if(!pWait->handles.empty() && (uNow >= pWait->uTimeoutNs))
+	{
+		for(unsigned i = 0; i < pWait->handles.size(); i++)
+		{
+			responses.Cancel(pWait->handles[i]);
+		}
+
+		pWait->handles.clear();
+		pWait->bTimedOut = true;
+	}
+
+	if(!pWait->handles.empty() || (uNow < pWait->uResumeNs))
+	{
+		return(false);
+	}
+
+	ReportWait(pWait);
+	pWait->bActive = false;
+	return(true);
+}
+
+void Autonomous::ReportWait(AutoWait *pWait)
+{
+	if(pWait->bTimedOut)
+	{
+		SmartDashboard::PutString("Auto Status","RESPONSE TIMEOUT!");
+		printf("%0.3lf %03d: response timeout\n", pDebugTimer->Get(), pWait->iLine);
+		FlightRecorder::Trigger("autoerror");
+	}
+	else if(pWait->bFailed)
+	{
+		SmartDashboard::PutString("Auto Status","EARLY DEATH!");
+		printf("%0.3lf %03d: command failed\n", pDebugTimer->Get(), pWait->iLine);
+		FlightRecorder::Trigger("autoerror");
+	}
+	else if(pWait->uResumeNs == 0)
+	{
+		SmartDashboard::PutString("Auto Status","auto ok");
+	}
+
+	if(iAutoDebugMode && (pWait->uResumeNs == 0))
+	{
+		printf("%0.3lf %03d: Response received\n", pDebugTimer->Get(), pWait->iLine);
+	}
 }
@@ -16,13 +16,19 @@
 #include "RobotParams.h"
 
 Component::Component()
-: ComponentBase(COMPONENT_TASKNAME, COMPONENT_QUEUE, COMPONENT_PRIORITY)
+: ComponentBase(COMPONENT_TASKNAME, ENDPOINT_COMPONENT, COMPONENT_PRIORITY,
+		COMPONENT_TRANSPORT, COMPONENT_TICK_PERIOD, COMPONENT_DEADLINE)
 {
 	//TODO: add member objects
-	pTask = new Task(COMPONENT_TASKNAME, (FUNCPTR) &Component::StartTask,
-			COMPONENT_PRIORITY, COMPONENT_STACKSIZE);
-	wpi_assert(pTask);
-	pTask->Start((int)this);
+	// with the executor enabled ComponentBase has already registered us there
+
+	if(!COMPONENT_EXECUTOR_ENABLED)
+	{
+		pTask = new Task(COMPONENT_TASKNAME, (FUNCPTR) &Component::StartTask,
+				COMPONENT_PRIORITY, COMPONENT_STACKSIZE);
+		wpi_assert(pTask);
+		pTask->Start((intptr_t)this);
+	}
 };
 
 Component::~Component()
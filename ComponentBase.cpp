@@ -8,11 +8,14 @@
 
 #include "ComponentBase.h"
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <assert.h>
 #include <errno.h>
 #include <fcntl.h>
-#include <sys/select.h>
+#include <sys/epoll.h>
+#include <sys/timerfd.h>
 #include <sys/types.h>
 
 //Local
@@ -20,13 +23,23 @@
 //Robot
 class RhsRobot;
 #include "RobotMessage.h"
+#include "RobotParams.h"
+#include "RobotTime.h"
+#include "ComponentExecutor.h"
+#include "TaskScheduler.h"
+#include "DataLog.h"
 
-ComponentBase::ComponentBase(const char* componentName, const char *queueName, int priority)
+ComponentBase::ComponentBase(const char* componentName, MessageEndpointId endpointId, int priority,
+		MessageTransport transport, float fTickPeriod, float fDeadline)
 {	
+	struct itimerspec timerSpec;
+	const char *queueName = ENDPOINT_QUEUES[endpointId];
+	std::string laneName;
+
+	this->componentName = strdup(componentName);
 	iLoop = 0;
-	iPipeRcv = -1;
-	iPipeXmt = -1;
 	pTask = NULL;
+	wakeReason = COMPONENT_WAKE_TICK;
 
 	pRemoteUpdateTimer = new Timer();
 	pRemoteUpdateTimer->Start();
@@ -40,66 +53,290 @@ ComponentBase::ComponentBase(const char* componentName, const char *queueName, i
 	pSafetyTimer = new Timer();
 	pSafetyTimer->Start();
 
-	mkfifo(queueName, 0666);
+	pStatsTimer = new Timer();
+	pStatsTimer->Start();
+	bStatsQueued.store(false);
+	bDumpQueued.store(false);
+	pTickJitter = new TaskJitter(componentName);
+	pLoopMonitor = new LoopMonitor(componentName, fTickPeriod, fDeadline);
+	pProfiler = new LoopProfiler(componentName);
+
+	pTrace = NULL;
+
+	if(MESSAGE_TRACE_ENABLED)
+	{
+		pTrace = new MessageTrace(componentName);
+	}
+
 	queueLocal = queueName;
+
+	// the executor never sleeps, so messages have to come through the rings in memory
+
+	if(COMPONENT_EXECUTOR_ENABLED)
+	{
+		transport = MESSAGE_TRANSPORT_RING;
+	}
+
+	bReadPipes = !COMPONENT_EXECUTOR_ENABLED;
+
+	// each priority lane has its own pipe and, if asked for, its own ring
+	// opening the pipes read/write means we never block waiting for a writer and
+	// never see end of file when a writer goes away
+
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+	{
+		laneName = MessageEndpoint::GetLaneName(queueName, (MessagePriority)i);
+		mkfifo(laneName.c_str(), 0666);
+		iPipeRcv[i] = open(laneName.c_str(), O_RDWR | O_NONBLOCK);
+		assert(iPipeRcv[i] > 0);
+		pRing[i] = NULL;
+
+		if(transport == MESSAGE_TRANSPORT_RING)
+		{
+			pRing[i] = new MessageRing(laneName.c_str(), true);
+		}
+	}
+
+	pEndpoint = MessageEndpoint::Register(endpointId, pRing);
+
+	// the component wakes for a message on any of its sources or for its periodic tick
+
+	uTickPeriod = SecondsToNs(fTickPeriod);
+	iTimer = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
+	assert(iTimer >= 0);
+	uNextTick = GetMonotonicNs() + uTickPeriod;
+	timerSpec.it_value = NsToTimespec(uNextTick);
+	timerSpec.it_interval = NsToTimespec(uTickPeriod);
+	timerfd_settime(iTimer, TFD_TIMER_ABSTIME, &timerSpec, NULL);
+
+	iEpoll = epoll_create(COMPONENT_EPOLL_EVENTS);
+	assert(iEpoll >= 0);
+	AddWakeSource(iTimer);
+
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+	{
+		AddWakeSource(iPipeRcv[i]);
+
+		if(pRing[i])
+		{
+			AddWakeSource(pRing[i]->GetEventFd());
+		}
+	}
+
+	for(int i = 0; i < TOPIC_LAST; i++)
+	{
+		bTopicWatched[i] = false;
+		uTopicSequence[i] = 0;
+	}
+
+	Subscribe(COMMAND_ROBOT_STATE_DISABLED);
+	Subscribe(COMMAND_ROBOT_STATE_AUTONOMOUS);
+	Subscribe(COMMAND_ROBOT_STATE_TELEOPERATED);
+	Subscribe(COMMAND_ROBOT_STATE_TEST);
+	Subscribe(COMMAND_ROBOT_STATE_UNKNOWN);
+
+	if(COMPONENT_EXECUTOR_ENABLED)
+	{
+		ComponentExecutor::GetInstance()->Register(this);
+	}
 }
 
-void ComponentBase::SendMessage(RobotMessage* robotMessage)
+ComponentBase::~ComponentBase()
 {
-	RobotMessage message = *robotMessage;
+	close(iEpoll);
+	close(iTimer);
 
-	if(iPipeXmt < 0)
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
 	{
-		iPipeXmt = open(queueLocal.c_str(), O_WRONLY);
-		//fcntl(iPipeXmt, F_SETFL, fcntl(iPipeXmt, F_GETFL) | O_NONBLOCK);
-		assert(iPipeXmt > 0);
+		close(iPipeRcv[i]);
+		delete pRing[i];
 	}
 
-	write(iPipeXmt, (char*)&message, sizeof(RobotMessage));
+	delete pTrace;
+	delete pTickJitter;
+	delete pLoopMonitor;
+	delete pProfiler;
+	free(componentName);
+}
+
+char* ComponentBase::GetComponentName()
+{
+	return(componentName);
+}
+
+void ComponentBase::AddWakeSource(int iFd, uint32_t uEvents)
+{
+	struct epoll_event event;
+
+	event.events = uEvents;
+	event.data.fd = iFd;
+	epoll_ctl(iEpoll, EPOLL_CTL_ADD, iFd, &event);
+}
+
+void ComponentBase::Subscribe(MessageCommand command)
+{
+	MessageTopicId topic = GetMessageTopic(command);
+
+	assert(topic != TOPIC_LAST);
+	subscriptions.set(command);
+
+	// the topic's eventfd is never read, edge triggering gives us one wakeup per publish
+
+	if(!bTopicWatched[topic])
+	{
+		bTopicWatched[topic] = true;
+		AddWakeSource(MessageTopic::Resolve(topic)->GetEventFd(), EPOLLIN | EPOLLET);
+	}
+}
+
+void ComponentBase::SendMessage(RobotMessage* robotMessage)
+{
+	pEndpoint->Send(robotMessage);
 }
 
 void ComponentBase::ReceiveMessage()			//Receives a message and copies it into localMessage
 {
-	fd_set selectSet;
-	struct timeval timeout;
+	struct epoll_event events[COMPONENT_EPOLL_EVENTS];
+	bool bSleep;
 
-	if(iPipeRcv < 0)
+	while(true)
 	{
-		iPipeRcv = open(queueLocal.c_str(), O_RDONLY);
-		assert(iPipeRcv > 0);
+		if(PollNextMessage())
+		{
+			return;
+		}
+
+		bSleep = true;
+
+		for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+		{
+			if(pRing[i] && !pRing[i]->PrepareWait())
+			{
+				bSleep = false;
+			}
+		}
+
+		if(bSleep)
+		{
+			pProfiler->Mark(LOOP_PHASE_RECEIVE);
+			epoll_wait(iEpoll, events, COMPONENT_EPOLL_EVENTS, -1);
+			pProfiler->Mark(LOOP_PHASE_WAIT);
+		}
+
+		for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+		{
+			if(pRing[i])
+			{
+				pRing[i]->FinishWait();
+			}
+		}
 	}
+}
 
-	FD_ZERO(&selectSet);
-	FD_SET(iPipeRcv, &selectSet);
+///Copies whatever should be handled next into localMessage without blocking
+bool ComponentBase::PollNextMessage()
+{
+	// broadcasts and urgent messages first, then a due tick so a busy queue
+	// can't starve the control loop, then everything else
+
+	return(PollTopics() ||
+			PollMessage(MESSAGE_PRIORITY_URGENT) ||
+			CheckTick() ||
+			PollMessage(MESSAGE_PRIORITY_NORMAL));
+}
 
-	timeout.tv_sec = 0;
-	timeout.tv_usec = 40000;
+///Copies a newly published broadcast we subscribe to into localMessage
+bool ComponentBase::PollTopics()
+{
+	RobotMessage topicMessage;
 
-	if(select(iPipeRcv + 1, &selectSet, NULL, NULL, &timeout) == 0)
+	for(int i = 0; i < TOPIC_LAST; i++)
 	{
-		localMessage.command = COMMAND_SYSTEM_MSGTIMEOUT;
+		if(bTopicWatched[i] &&
+				MessageTopic::Resolve((MessageTopicId)i)->Read(&uTopicSequence[i], &topicMessage) &&
+				(topicMessage.header.uVersion == ROBOT_MESSAGE_VERSION) &&
+				((unsigned)topicMessage.command < COMMAND_LAST) &&
+				subscriptions.test(topicMessage.command))
+		{
+			localMessage = topicMessage;
+			wakeReason = COMPONENT_WAKE_MESSAGE;
+			return(true);
+		}
 	}
-	else
+
+	return(false);
+}
+
+///Copies the next message waiting in one lane into localMessage without blocking
+bool ComponentBase::PollMessage(MessagePriority lane)
+{
+	wakeReason = COMPONENT_WAKE_MESSAGE;
+
+	while((pRing[lane] && pRing[lane]->Pop(&localMessage)) ||
+			(bReadPipes &&
+			(read(iPipeRcv[lane], (char*)&localMessage, sizeof(RobotMessage)) == sizeof(RobotMessage))))
 	{
-		read(iPipeRcv, (char*)&localMessage, sizeof(RobotMessage));
+		pEndpoint->Dequeued(lane);
+
+		// a message laid out by some other build of the code can't be trusted and a
+		// retired placeholder is out of date, drop either
+
+		if((localMessage.header.uVersion == ROBOT_MESSAGE_VERSION) && pEndpoint->Collect(&localMessage))
+		{
+			return(true);
+		}
 	}
+
+	return(false);
+}
+
+///Returns true and sets up a tick wakeup if the component's period has elapsed
+bool ComponentBase::CheckTick()
+{
+	uint64_t uNow = GetMonotonicNs();
+	uint64_t uExpirations;
+
+	if(uNow < uNextTick)
+	{
+		return(false);
+	}
+
+	pTickJitter->Woke(uNextTick);
+
+	// eat the timer expiration and skip any periods we were too busy to run
+
+	if(bReadPipes)
+	{
+		read(iTimer, &uExpirations, sizeof(uExpirations));
+	}
+
+	do
+	{
+		uNextTick += uTickPeriod;
+	}
+	while(uNextTick <= uNow);
+
+	wakeReason = COMPONENT_WAKE_TICK;
+	localMessage.command = COMMAND_SYSTEM_MSGTIMEOUT;
+	return(true);
 }
 
 void ComponentBase::ClearMessages(void)
 {
 	RobotMessage eatMessage;
 	
-	// eat all the messages in the queue
-	
-	fcntl(iPipeRcv, F_SETFL, O_NONBLOCK);
+	// eat all the messages in the queue, collecting them so conflated commands can be sent again
 
-	while(read(iPipeRcv, (char*)&eatMessage, sizeof(RobotMessage)) > 0)
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
 	{
-		// intentionally empty
+		while((pRing[i] && pRing[i]->Pop(&eatMessage)) ||
+				(read(iPipeRcv[i], (char*)&eatMessage, sizeof(RobotMessage)) == sizeof(RobotMessage)))
+		{
+			pEndpoint->Dequeued((MessagePriority)i);
+			pEndpoint->Collect(&eatMessage);
+		}
 	}
 
-	fcntl(iPipeRcv, F_SETFL, 0);
-
 	// make sure the localMessage is innocuous
 	
 	localMessage.command = COMMAND_SYSTEM_MSGTIMEOUT;
@@ -107,41 +344,201 @@ void ComponentBase::ClearMessages(void)
 
 void ComponentBase::DoWork()
 {
+	TaskScheduler::ConfigureTask(componentName);
+
 	while(true)
 	{
 		ReceiveMessage();		//Receives a message and copies it into localMessage
+		Dispatch();
+	}
+}
+
+/**
+ * Called by the ComponentExecutor instead of DoWork, handles what is waiting without
+ * blocking.  Returns the number of messages and ticks handled.
+ */
+int ComponentBase::Service(int iMaxMessages)
+{
+	int iHandled = 0;
+
+	// time spent servicing the components before us isn't ours
+
+	pProfiler->Restart();
+
+	while((iHandled < iMaxMessages) && PollNextMessage())
+	{
+		Dispatch();
+		iHandled++;
+	}
+
+	return(iHandled);
+}
+
+///Handles the message or tick in localMessage
+void ComponentBase::Dispatch()
+{
+	if(pTrace)
+	{
+		if(wakeReason == COMPONENT_WAKE_MESSAGE)
+		{
+			pTrace->Dequeued(&localMessage);
+		}
+		else
+		{
+			pTrace->Ticked();
+		}
+	}
+
+	if(wakeReason == COMPONENT_WAKE_MESSAGE)
+	{
+		LogMessage();
+	}
+
+	// a match starts in autonomous, its numbers shouldn't include the practice before it
+
+	if((wakeReason == COMPONENT_WAKE_MESSAGE) &&
+			(localMessage.command == COMMAND_ROBOT_STATE_AUTONOMOUS))
+	{
+		ResetStats();
+	}
+
+	pLoopMonitor->Begin(localMessage.command);
+	pProfiler->Mark(LOOP_PHASE_RECEIVE);
+
+	if(localMessage.command == COMMAND_ROBOT_STATE_DISABLED ||			//Tests for state change messages
+			localMessage.command == COMMAND_ROBOT_STATE_AUTONOMOUS ||
+			localMessage.command == COMMAND_ROBOT_STATE_TELEOPERATED ||
+			localMessage.command == COMMAND_ROBOT_STATE_TEST ||
+			localMessage.command == COMMAND_ROBOT_STATE_UNKNOWN)
+	{
+		OnStateChange();			//Handles state changes
+		pProfiler->Mark(LOOP_PHASE_STATE_CHANGE);
+	}
+
+	Run();			//Component logic
+	pProfiler->Mark(LOOP_PHASE_RUN);
+	//
+	//if(ISAUTO) { AutoBehavior(); } //TODO should we add AutoBehavior?
+	//AutoBehavior is where the actual auto stuff is called - it should be periodic rather than stop up the thread
+	//It should be structured as a state machine; Run will change the state.
+
+	pLoopMonitor->End();
+
+	if(pTrace)
+	{
+		pTrace->Handled();
+
+		// the robot is sitting still, a good time to write the file out; the histograms
+		// are atomic like the stats, so a background worker does the file system part
 
-		if(localMessage.command == COMMAND_ROBOT_STATE_DISABLED ||			//Tests for state change messages
-				localMessage.command == COMMAND_ROBOT_STATE_AUTONOMOUS ||
-				localMessage.command == COMMAND_ROBOT_STATE_TELEOPERATED ||
-				localMessage.command == COMMAND_ROBOT_STATE_TEST ||
-				localMessage.command == COMMAND_ROBOT_STATE_UNKNOWN)
+		if((wakeReason == COMPONENT_WAKE_MESSAGE) &&
+				(localMessage.command == COMMAND_ROBOT_STATE_DISABLED) &&
+				!bDumpQueued.exchange(true))
 		{
-			OnStateChange();			//Handles state changes
+			TaskScheduler::GetInstance()->Submit(&ComponentBase::DumpTraceJob, this);
 		}
+	}
+
+	// everything PublishStats reads is atomic, so a background worker can do the
+	// slow dashboard part; skip a round if the last one hasn't run yet
+
+	if(pStatsTimer->Get() > MESSAGE_STATS_PUBLISH_PERIOD)
+	{
+		pStatsTimer->Reset();
 
-		Run();			//Component logic
-		//
-		//if(ISAUTO) { AutoBehavior(); } //TODO should we add AutoBehavior?
-		//AutoBehavior is where the actual auto stuff is called - it should be periodic rather than stop up the thread
-		//It should be structured as a state machine; Run will change the state.
-		if (pRemoteUpdateTimer->Get() > fUpdateDelay)
+		if(!bStatsQueued.exchange(true))
 		{
-			pRemoteUpdateTimer->Reset();
-			SmartDashboardUpdate();
+			TaskScheduler::GetInstance()->Submit(&ComponentBase::PublishStatsJob, this);
 		}
-		lastCommand = localMessage.command;
-		iLoop++;
 	}
+
+	pProfiler->Mark(LOOP_PHASE_STATS);
+
+	if (pRemoteUpdateTimer->Get() > fUpdateDelay)
+	{
+		pRemoteUpdateTimer->Reset();
+		SmartDashboardUpdate();
+		pProfiler->Mark(LOOP_PHASE_DASHBOARD);
+	}
+	lastCommand = localMessage.command;
+	iLoop++;
+	pProfiler->EndPass();
 }
+
+///Puts the message we are about to handle, and how long it queued, in the data log
+void ComponentBase::LogMessage()
+{
+	uint64_t uNow = GetMonotonicNs();
+	float fLatencyUs = 0.0;
+
+	if((localMessage.header.uSendTime != 0) && (uNow > localMessage.header.uSendTime))
+	{
+		fLatencyUs = (uNow - localMessage.header.uSendTime) / (float)NS_PER_USEC;
+	}
+
+	DataLog::Record(DATALOG_TYPE_MESSAGE, pEndpoint->GetId(), localMessage.command, fLatencyUs,
+			localMessage.header.uSource);
+}
+
+///Queue gauges, deadline misses, loop phase times and, if enabled, message trace histograms, tick lateness goes out with the core load
+void ComponentBase::PublishStats()
+{
+	pEndpoint->Publish();
+	pLoopMonitor->Publish();
+	pProfiler->Publish();
+
+	if(pTrace)
+	{
+		pTrace->Publish();
+	}
+
+	bStatsQueued.store(false);
+}
+
+///Writes the message trace histograms to MESSAGE_TRACE_DIRECTORY, off the component's thread
+void ComponentBase::DumpTrace()
+{
+	pTrace->Dump(MESSAGE_TRACE_DIRECTORY);
+	bDumpQueued.store(false);
+}
+
+///Starts the per match statistics over
+void ComponentBase::ResetStats()
+{
+	pLoopMonitor->Reset();
+	pProfiler->Reset();
+	pTickJitter->Reset();
+
+	if(pTrace)
+	{
+		pTrace->Reset();
+	}
+}
+
 void ComponentBase::SendCommandResponse(MessageCommand command)
+{
+	SendCommandResponse(command, localMessage.header);
+}
+
+///Responds to a request received earlier, keep its header until the work is done
+void ComponentBase::SendCommandResponse(MessageCommand command, const MessageHeader &request)
 {
 	RobotMessage replyMessage;
-		replyMessage.command = command;
-		//Send a message back to auto to tell it that code is done.
-		int iPipeXmt = open(localMessage.replyQ, O_WRONLY);
-		assert(iPipeXmt > 0);
 
-		write(iPipeXmt, (char*) &replyMessage, sizeof(RobotMessage));
-		close(iPipeXmt);
+	// the main robot task has no queue to answer to, and a request without a
+	// correlation ID was sent by someone not waiting for an answer
+
+	if((request.uReply == ENDPOINT_NONE) || (request.uReply >= ENDPOINT_LAST) ||
+			(request.uCorrelation == 0))
+	{
+		return;
+	}
+
+	replyMessage.command = command;
+	replyMessage.header.uSource = pEndpoint->GetId();
+	replyMessage.header.uReply = pEndpoint->GetId();
+	replyMessage.header.uFlags = 0;
+	replyMessage.header.uCorrelation = request.uCorrelation;
+	//Send a message back to auto to tell it that code is done.
+	MessageEndpoint::Resolve((MessageEndpointId)request.uReply)->Send(&replyMessage);
 }
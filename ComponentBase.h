@@ -16,7 +16,11 @@
 #include <errno.h>
 #include <mqueue.h>		     /* for POSIX message queues */
 #include <unistd.h>			/* for pipes */
+#include <stdint.h>
+#include <sys/epoll.h>		/* for the wake sources */
 
+#include <atomic>
+#include <bitset>
 #include <string>
 #include <iostream>
 using namespace std;
@@ -25,14 +29,38 @@ using namespace std;
 
 //Robot
 #include "RobotMessage.h"			//For the RobotMessage struct
+#include "MessageRing.h"			//For the shared memory transport
+#include "MessageEndpoint.h"		//For sending to other queues
+#include "MessageTrace.h"			//For per command latency histograms
+#include "TaskJitter.h"			//For tick lateness
+#include "LoopMonitor.h"			//For deadline misses and stalls
+#include "LoopProfiler.h"			//For where each pass spends its time
+#include "MessageTopic.h"			//For broadcast state changes
+
+///how often a component runs when no messages arrive, unless it asks for something else
+const float DEFAULT_TICK_PERIOD = 0.040;
+///longest one pass through OnStateChange/Run may take before it counts as a miss
+const float DEFAULT_DEADLINE = 0.040;
+///pipe and ring eventfd for each lane, the tick timer and each topic
+const int COMPONENT_EPOLL_EVENTS = 2 * MESSAGE_PRIORITY_LANES + 1 + TOPIC_LAST;
+
+///Why DoWork called Run() this time around
+typedef enum eComponentWake
+{
+	COMPONENT_WAKE_MESSAGE,			//!< localMessage holds a newly received message
+	COMPONENT_WAKE_TICK				//!< the component's periodic timer fired, localMessage is MSGTIMEOUT
+} ComponentWake;
 
 class ComponentBase
 {
 public:
-	ComponentBase(const char* componentName, const char *queueName, int priority);
-	virtual ~ComponentBase() {};
+	ComponentBase(const char* componentName, MessageEndpointId endpointId, int priority,
+			MessageTransport transport = MESSAGE_TRANSPORT_PIPE,
+			float fTickPeriod = DEFAULT_TICK_PERIOD, float fDeadline = DEFAULT_DEADLINE);
+	virtual ~ComponentBase();
 
 	void DoWork();
+	int Service(int iMaxMessages);
 	void SendMessage(RobotMessage* robotMessage);
 	void ClearMessages();
 
@@ -46,6 +74,7 @@ protected:
 	Task *pTask;
 	RobotMessage localMessage;
 	MessageCommand lastCommand;//used to detect changes in commands sent
+	ComponentWake wakeReason;
 	int iLoop;
 
 	virtual void OnStateChange() = 0;
@@ -55,17 +84,54 @@ protected:
 
 	///used to send a message back to autonomous or whatever to notify completion of a function
 	void SendCommandResponse(MessageCommand);
+	void SendCommandResponse(MessageCommand, const MessageHeader &request);
+	///receive a broadcast command, every component subscribes to the robot state commands
+	void Subscribe(MessageCommand command);
 
 private:
 	const float fUpdateDelay = .15;
 	char* componentName;
 	string queueLocal;
-	int iPipeRcv;
-	int iPipeXmt;
+	int iPipeRcv[MESSAGE_PRIORITY_LANES];
 	int iPipeRpt;
+	int iTimer;
+	int iEpoll;
+	uint64_t uTickPeriod;
+	uint64_t uNextTick;
+	MessageRing *pRing[MESSAGE_PRIORITY_LANES];
+	MessageEndpoint *pEndpoint;
+	std::bitset<COMMAND_LAST> subscriptions;
+	bool bTopicWatched[TOPIC_LAST];
+	uint32_t uTopicSequence[TOPIC_LAST];
+	MessageTrace *pTrace;
+	TaskJitter *pTickJitter;
+	LoopMonitor *pLoopMonitor;
+	LoopProfiler *pProfiler;
+	std::atomic<bool> bStatsQueued;
+	std::atomic<bool> bDumpQueued;
+	bool bReadPipes;
 	Timer *pRemoteUpdateTimer;
+	Timer *pStatsTimer;
 
+	void AddWakeSource(int iFd, uint32_t uEvents = EPOLLIN);
 	void ReceiveMessage();
+	void Dispatch();
+	void LogMessage();
+	void PublishStats();
+	void ResetStats();
+	static void PublishStatsJob(void *pThis)
+	{
+		((ComponentBase *)pThis)->PublishStats();
+	}
+	void DumpTrace();
+	static void DumpTraceJob(void *pThis)
+	{
+		((ComponentBase *)pThis)->DumpTrace();
+	}
+	bool PollNextMessage();
+	bool PollTopics();
+	bool PollMessage(MessagePriority lane);
+	bool CheckTick();
 	void ReportMessage();
 };
 
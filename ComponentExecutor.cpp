@@ -0,0 +1,75 @@
+/** \file
+ * Single task component executor implementation.
+ *
+ * Components keep their own tick periods; the executor tick only has to be as short as
+ * the fastest of them.  A message waits at most one executor tick before it is handled.
+ */
+
+#include "ComponentExecutor.h"
+
+//Robot
+#include "ComponentBase.h"
+#include "RobotParams.h"
+#include "RobotTime.h"
+#include "TaskScheduler.h"
+
+ComponentExecutor::ComponentExecutor()
+: jitter(EXECUTOR_TASKNAME)
+{
+	pTask = NULL;
+	uTickPeriod = SecondsToNs(EXECUTOR_TICK_PERIOD);
+}
+
+ComponentExecutor *ComponentExecutor::GetInstance()
+{
+	static ComponentExecutor executor;
+
+	return(&executor);
+}
+
+///Called from the ComponentBase constructor, components are serviced in this order
+void ComponentExecutor::Register(ComponentBase *pComponent)
+{
+	components.push_back(pComponent);
+}
+
+///Called once every component has been constructed
+void ComponentExecutor::Start()
+{
+	if(pTask)
+	{
+		return;
+	}
+
+	pTask = new Task(EXECUTOR_TASKNAME, (FUNCPTR) &ComponentExecutor::StartTask,
+			EXECUTOR_PRIORITY, EXECUTOR_STACKSIZE);
+	wpi_assert(pTask);
+	pTask->Start((intptr_t)this);
+}
+
+void ComponentExecutor::DoWork()
+{
+	uint64_t uNextTick = GetMonotonicNs();
+
+	TaskScheduler::ConfigureTask(EXECUTOR_TASKNAME);
+
+	while(true)
+	{
+		for(unsigned i = 0; i < components.size(); i++)
+		{
+			components[i]->Service(EXECUTOR_MESSAGES_PER_TICK);
+		}
+
+		// sleep to an absolute time so time spent servicing doesn't add up as drift,
+		// and skip any ticks we were too busy to run
+
+		uNextTick += uTickPeriod;
+
+		if(uNextTick < GetMonotonicNs())
+		{
+			uNextTick = GetMonotonicNs();
+		}
+
+		jitter.SleepUntil(uNextTick);
+	}
+}
@@ -0,0 +1,47 @@
+/** \file
+ * Single task component executor declaration.
+ *
+ * With COMPONENT_EXECUTOR_ENABLED every component registers here instead of starting
+ * its own Task.  One executor task wakes every EXECUTOR_TICK_PERIOD and services the
+ * components in the order they were constructed: each handles the messages waiting
+ * in its rings and its own tick if that is due.  Messages travel through the rings in
+ * memory and nobody sleeps on a ring, so delivering them costs no system calls.
+ */
+
+#ifndef COMPONENT_EXECUTOR_H
+#define COMPONENT_EXECUTOR_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "WPILib.h"
+
+//Robot
+#include "TaskJitter.h"
+
+class ComponentBase;
+
+class ComponentExecutor
+{
+public:
+	static ComponentExecutor *GetInstance();
+	static void *StartTask(void *pThis)
+	{
+		((ComponentExecutor *)pThis)->DoWork();
+		return(NULL);
+	}
+
+	void Register(ComponentBase *pComponent);
+	void Start();
+
+private:
+	std::vector<ComponentBase *> components;
+	Task *pTask;
+	uint64_t uTickPeriod;
+	TaskJitter jitter;
+
+	ComponentExecutor();
+	void DoWork();
+};
+
+#endif //COMPONENT_EXECUTOR_H
@@ -0,0 +1,246 @@
+/** \file
+ * High rate binary data logger implementation.
+ */
+
+#include "DataLog.h"
+#include <stdio.h>
+#include <stddef.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+//Robot
+#include "RobotTime.h"
+#include "FlightRecorder.h"
+#include "TaskScheduler.h"
+
+///records Drain copies out of the memory ring per system call
+const int DATALOG_CHUNK = 256;
+
+DataLogHeader *DataLog::pHeader = NULL;
+int DataLog::iFile = -1;
+uint64_t DataLog::uFileCapacity = 0;
+uint64_t DataLog::uDrained = 0;
+pthread_mutex_t DataLog::drainMutex = PTHREAD_MUTEX_INITIALIZER;
+std::atomic<bool> DataLog::bQueued(false);
+
+/**
+ * Creates the log file at its full size, keeping the last run's log as szPath.prev, and
+ * allocates the memory ring records go to first.  Called once at start up after the
+ * memory lock, so the ring is resident; until it succeeds Record() does nothing.
+ */
+bool DataLog::Open(const char *szPath, uint64_t uCapacity, uint64_t uBufferRecords)
+{
+	char szPrevious[256];
+	size_t size = sizeof(DataLogHeader) + uBufferRecords * sizeof(DataLogRecord);
+	DataLogHeader *pNewHeader;
+	DataLogHeader fileHeader;
+
+	if(pHeader != NULL)
+	{
+		return(true);
+	}
+
+	snprintf(szPrevious, sizeof(szPrevious), "%s.prev", szPath);
+	rename(szPath, szPrevious);
+
+	iFile = open(szPath, O_RDWR | O_CREAT | O_TRUNC, 0644);
+
+	if(iFile < 0)
+	{
+		printf("Data log %s could not be created\n", szPath);
+		return(false);
+	}
+
+	// allocate every block now so draining never has to, every slot reads as unwritten
+
+	if(posix_fallocate(iFile, 0, sizeof(DataLogHeader) + uCapacity * sizeof(DataLogRecord)) != 0)
+	{
+		printf("Data log %s could not be allocated\n", szPath);
+		close(iFile);
+		iFile = -1;
+		return(false);
+	}
+
+	// one block, header then ring, as Append expects
+
+	pNewHeader = (DataLogHeader *)new char[size];
+	memset(pNewHeader, 0, size);
+	memcpy(pNewHeader->szMagic, DATALOG_MAGIC, sizeof(pNewHeader->szMagic));
+	pNewHeader->uVersion = DATALOG_VERSION;
+	pNewHeader->uRecordSize = sizeof(DataLogRecord);
+	pNewHeader->uCapacity = uBufferRecords;
+	pNewHeader->uNextRecord = 0;
+	pNewHeader->uStartTimeNs = GetMonotonicNs();
+
+	// the file's header is the same but for its capacity, Drain keeps its count
+
+	fileHeader = *pNewHeader;
+	fileHeader.uCapacity = uCapacity;
+
+	if(pwrite(iFile, &fileHeader, sizeof(fileHeader), 0) != sizeof(fileHeader))
+	{
+		printf("Data log %s could not be written\n", szPath);
+		close(iFile);
+		iFile = -1;
+		delete[] (char *)pNewHeader;
+		return(false);
+	}
+
+	uFileCapacity = uCapacity;
+	__atomic_store_n(&pHeader, pNewHeader, __ATOMIC_RELEASE);
+	return(true);
+}
+
+///Has a background worker drain the memory ring to the file, safe from any task
+void DataLog::Flush()
+{
+	if(__atomic_load_n(&pHeader, __ATOMIC_ACQUIRE) == NULL)
+	{
+		return;
+	}
+
+	if(!bQueued.exchange(true))
+	{
+		TaskScheduler::GetInstance()->Submit(&DataLog::DrainJob, NULL);
+	}
+}
+
+/**
+ * Writes every record logged since the last drain to the file, then the file header's
+ * count.  A record still being filled in is left for the next drain unless the ring is
+ * about to lap it; one that was overwritten while we copied it goes out torn.  This
+ * takes a while, control loops should use Flush().
+ */
+bool DataLog::Drain()
+{
+	DataLogRecord chunk[DATALOG_CHUNK];
+	DataLogHeader *pLog = __atomic_load_n(&pHeader, __ATOMIC_ACQUIRE);
+	DataLogRecord *pRecords;
+	DataLogRecord *pRecord;
+	uint64_t uEnd;
+	uint64_t uSlot;
+	uint64_t uCount;
+	uint32_t uSequence;
+	bool bWaiting = false;
+	bool bReturn = true;
+
+	if(pLog == NULL)
+	{
+		return(false);
+	}
+
+	pRecords = (DataLogRecord *)(pLog + 1);
+	pthread_mutex_lock(&drainMutex);
+	uEnd = __atomic_load_n(&pLog->uNextRecord, __ATOMIC_ACQUIRE);
+
+	// whatever the ring has already overwritten is gone, its slots in the file keep
+	// records from an earlier lap and readers skip them
+
+	if(uEnd - uDrained > pLog->uCapacity)
+	{
+		uDrained = uEnd - pLog->uCapacity;
+	}
+
+	while(bReturn && !bWaiting && (uDrained < uEnd))
+	{
+		uSlot = uDrained % uFileCapacity;
+		uCount = uEnd - uDrained;
+
+		if(uCount > (uint64_t)DATALOG_CHUNK)
+		{
+			uCount = DATALOG_CHUNK;
+		}
+
+		if(uCount > uFileCapacity - uSlot)
+		{
+			uCount = uFileCapacity - uSlot;
+		}
+
+		for(uint64_t i = 0; i < uCount; i++)
+		{
+			pRecord = &pRecords[(uDrained + i) % pLog->uCapacity];
+
+			uSequence = __atomic_load_n(&pRecord->uSequence, __ATOMIC_ACQUIRE);
+			chunk[i] = *pRecord;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+			if((__atomic_load_n(&pRecord->uSequence, __ATOMIC_RELAXED) != uSequence) ||
+					(uSequence != (uint32_t)(uDrained + i + 1)))
+			{
+				if(uEnd - (uDrained + i) < pLog->uCapacity / 2)
+				{
+					uCount = i;
+					bWaiting = true;
+					break;
+				}
+
+				uSequence = 0;
+			}
+
+			chunk[i].uSequence = uSequence;
+		}
+
+		if(pwrite(iFile, chunk, uCount * sizeof(DataLogRecord),
+				sizeof(DataLogHeader) + uSlot * sizeof(DataLogRecord)) != (ssize_t)(uCount * sizeof(DataLogRecord)))
+		{
+			bReturn = false;
+		}
+
+		uDrained += uCount;
+	}
+
+	if(pwrite(iFile, &uDrained, sizeof(uDrained), offsetof(DataLogHeader, uNextRecord)) != sizeof(uDrained))
+	{
+		bReturn = false;
+	}
+
+	pthread_mutex_unlock(&drainMutex);
+	return(bReturn);
+}
+
+///Safe from any task at any rate, drops the sample if the log isn't open
+void DataLog::Record(DataLogType type, uint16_t uSource, float fValue0, float fValue1,
+		float fValue2, float fValue3)
+{
+	uint64_t uNow = GetMonotonicNs();
+
+	Append(__atomic_load_n(&pHeader, __ATOMIC_ACQUIRE), type, uSource, uNow, fValue0,
+			fValue1, fValue2, fValue3);
+	FlightRecorder::Record(type, uSource, uNow, fValue0, fValue1, fValue2, fValue3);
+}
+
+/**
+ * Writes one record to a ring laid out as a data log, lock free, does nothing if pLog is
+ * NULL.  The records follow the header in memory as they do in the file, so the ring
+ * always comes from the same header the caller acquired.
+ */
+void DataLog::Append(DataLogHeader *pLog, DataLogType type, uint16_t uSource, uint64_t uTimeNs,
+		float fValue0, float fValue1, float fValue2, float fValue3)
+{
+	DataLogRecord *pRecord;
+	uint64_t uRecord;
+
+	if(pLog == NULL)
+	{
+		return;
+	}
+
+	uRecord = __atomic_fetch_add(&pLog->uNextRecord, 1, __ATOMIC_RELAXED);
+	pRecord = (DataLogRecord *)(pLog + 1) + uRecord % pLog->uCapacity;
+
+	// mark the slot torn while we fill it, then publish it with its sequence
+
+	__atomic_store_n(&pRecord->uSequence, 0, __ATOMIC_RELAXED);
+	__atomic_thread_fence(__ATOMIC_RELEASE);
+
+	pRecord->uType = type;
+	pRecord->uSource = uSource;
+	pRecord->uTimeNs = uTimeNs;
+	pRecord->fValues[0] = fValue0;
+	pRecord->fValues[1] = fValue1;
+	pRecord->fValues[2] = fValue2;
+	pRecord->fValues[3] = fValue3;
+
+	__atomic_store_n(&pRecord->uSequence, (uint32_t)(uRecord + 1), __ATOMIC_RELEASE);
+}
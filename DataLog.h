@@ -0,0 +1,53 @@
+/** \file
+ * High rate binary data logger declaration.
+ *
+ * Samples go into a ring in memory, allocated at start up after the memory lock and
+ * laid out like the FlightRecorder's, so logging one is a fetch-and-add to reserve a
+ * record and a 32 byte copy: it never allocates, takes a lock, makes a system call or
+ * touches a page the kernel could be writing back.  Any task may log.  Every
+ * DATALOG_FLUSH_PERIOD the main loop has a background worker drain what is new to the
+ * log file with write(), each record to the slot of the file's own, much larger ring
+ * that its number implies.  If the worker falls so far behind that the memory ring
+ * laps it, the records it missed are lost and readers skip their slots.  When the file's
+ * ring is full the oldest records are overwritten.  The previous run's log is kept
+ * beside the new one, and tools/DataLogExport.cpp turns either into CSV or columns.
+ * Every record also goes to the FlightRecorder, whether or not the log is open, which
+ * is what to look at for the moments before a crash that were never drained.
+ */
+
+#ifndef DATA_LOG_H
+#define DATA_LOG_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+
+//Robot
+#include "DataLogFormat.h"
+
+class DataLog
+{
+public:
+	static bool Open(const char *szPath, uint64_t uCapacity, uint64_t uBufferRecords);
+	static void Record(DataLogType type, uint16_t uSource, float fValue0, float fValue1 = 0.0,
+			float fValue2 = 0.0, float fValue3 = 0.0);
+	static void Append(DataLogHeader *pLog, DataLogType type, uint16_t uSource, uint64_t uTimeNs,
+			float fValue0, float fValue1, float fValue2, float fValue3);
+	static void Flush();
+	static bool Drain();
+	static void DrainJob(void *pUnused)
+	{
+		Drain();
+		bQueued.store(false);
+	}
+
+private:
+	static DataLogHeader *pHeader;
+	static int iFile;
+	static uint64_t uFileCapacity;
+	static uint64_t uDrained;
+	static pthread_mutex_t drainMutex;
+	static std::atomic<bool> bQueued;
+};
+
+#endif //DATA_LOG_H
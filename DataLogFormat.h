@@ -0,0 +1,89 @@
+/** \file
+ * Binary data log file format.
+ *
+ * Shared by the robot and the offline export tool, so it must not include WPILib or
+ * anything else robot specific.  The file is a DataLogHeader followed by uCapacity
+ * DataLogRecords used as a ring: record N lives at slot N % uCapacity and carries
+ * sequence N + 1 once it is completely written.  A slot whose sequence is not the one
+ * its position implies is either unwritten or was being written when the robot
+ * stopped, and readers skip it.  Everything is little endian, as the roboRIO is.
+ */
+
+#ifndef DATA_LOG_FORMAT_H
+#define DATA_LOG_FORMAT_H
+
+#include <stdint.h>
+
+const char DATALOG_MAGIC[8] = { 'R', 'H', 'S', 'L', 'O', 'G', '0', '1' };
+const uint32_t DATALOG_VERSION = 1;
+const int DATALOG_VALUES = 4;
+
+typedef enum eDataLogType
+{
+	DATALOG_TYPE_GYRO,				//!< rate deg/s, angle deg, bias deg/s, still 0 or 1
+	DATALOG_TYPE_DRIVE,				//!< left, right motor setpoints
+	DATALOG_TYPE_MESSAGE,			//!< command, queue latency us, sender, handled by uSource
+	DATALOG_TYPE_SEND,				//!< command, receiver, correlation, sent by uSource
+	DATALOG_TYPE_STATE,				//!< robot state, previous state
+	DATALOG_TYPE_STICK,				//!< buttons, pov of joystick uSource
+	DATALOG_TYPE_AXES_LOW,			//!< axes 0-3 of joystick uSource
+	DATALOG_TYPE_AXES_HIGH,			//!< axes 4-7 of joystick uSource
+	DATALOG_TYPE_DRIVER_STATION,	//!< DATALOG_MODE bits, logged after the joysticks of the same packet
+	DATALOG_TYPE_SPI,				//!< the four bytes read from SPI port uSource
+	DATALOG_TYPE_LAST
+} DataLogType;
+
+///Column names for each type's values, empty where a type doesn't use one
+const char *const DATALOG_COLUMNS[DATALOG_TYPE_LAST][DATALOG_VALUES] = {
+	{ "rate", "angle", "bias", "still" },
+	{ "left", "right", "", "" },
+	{ "command", "latency_us", "from", "" },
+	{ "command", "to", "correlation", "" },
+	{ "state", "previous", "", "" },
+	{ "buttons", "pov", "", "" },
+	{ "axis0", "axis1", "axis2", "axis3" },
+	{ "axis4", "axis5", "axis6", "axis7" },
+	{ "mode", "", "", "" },
+	{ "byte0", "byte1", "byte2", "byte3" }
+};
+
+const char *const DATALOG_TYPE_NAMES[DATALOG_TYPE_LAST] = {
+	"gyro",
+	"drive",
+	"message",
+	"send",
+	"state",
+	"stick",
+	"axes_low",
+	"axes_high",
+	"driver_station",
+	"spi"
+};
+
+///Bits of a driver station record's mode
+const int DATALOG_MODE_ENABLED = 0x1;
+const int DATALOG_MODE_AUTONOMOUS = 0x2;
+const int DATALOG_MODE_TEST = 0x4;
+
+struct DataLogHeader {
+	char szMagic[8];
+	uint32_t uVersion;
+	uint32_t uRecordSize;			//!< sizeof(DataLogRecord)
+	uint64_t uCapacity;				//!< records in the ring
+	uint64_t uNextRecord;			//!< records ever reserved, the next one's number
+	uint64_t uStartTimeNs;			//!< CLOCK_MONOTONIC when the log was opened
+	uint8_t uReserved[24];			//!< pads the header to 64 bytes
+};
+
+struct DataLogRecord {
+	uint32_t uSequence;				//!< record number + 1, written last
+	uint16_t uType;					//!< DataLogType
+	uint16_t uSource;				//!< MessageEndpointId that logged it, 0 if none
+	uint64_t uTimeNs;				//!< CLOCK_MONOTONIC
+	float fValues[DATALOG_VALUES];
+};
+
+static_assert(sizeof(DataLogHeader) == 64, "DataLogHeader layout changed");
+static_assert(sizeof(DataLogRecord) == 32, "DataLogRecord layout changed");
+
+#endif //DATA_LOG_FORMAT_H
@@ -24,11 +24,15 @@
 
 #include "ComponentBase.h"
 #include "RobotParams.h"
+#include "RobotTime.h"
+#include "Telemetry.h"
+#include "DataLog.h"
 using namespace std;
 
 Drivetrain::Drivetrain() :
-		ComponentBase(DRIVETRAIN_TASKNAME, DRIVETRAIN_QUEUE,
-				DRIVETRAIN_PRIORITY) {
+		ComponentBase(DRIVETRAIN_TASKNAME, ENDPOINT_DRIVETRAIN,
+				DRIVETRAIN_PRIORITY, DRIVETRAIN_TRANSPORT, DRIVETRAIN_TICK_PERIOD,
+				DRIVETRAIN_DEADLINE) {
 
 	leftMotor = new CANTalon(CAN_DRIVETRAIN_LEFT_MOTOR);
 	rightMotor = new CANTalon(CAN_DRIVETRAIN_RIGHT_MOTOR);
@@ -47,14 +51,26 @@ Drivetrain::Drivetrain() :
 	wpi_assert(gyro);
 	gyro->Start();
 
+	angleErrorKey = Telemetry::Intern("Angle Error", TELEMETRY_RATE_FAST);
+	turnSpeedKey = Telemetry::Intern("Turn Speed", TELEMETRY_RATE_FAST);
+	angleAdjustmentKey = Telemetry::Intern("Angle Adjustment", TELEMETRY_RATE_NORMAL);
+	gyroAngleKey = Telemetry::Intern("Gyro Angle", TELEMETRY_RATE_NORMAL);
+	disableLatencyKey = Telemetry::Intern("Disable Latency ms", TELEMETRY_RATE_SLOW);
+	maxDisableLatencyKey = Telemetry::Intern("Max Disable Latency ms", TELEMETRY_RATE_SLOW);
+
 	//encoder = new Encoder(0, 1, false, Encoder::k4X);
 	//encoder->SetDistancePerPulse(fEncoderRatio); //diameter*pi/encoder_resolution
 	//wpi_assert(encoder);
 
-	pTask = new Task(DRIVETRAIN_TASKNAME, (FUNCPTR) &Drivetrain::StartTask,
-			DRIVETRAIN_PRIORITY, DRIVETRAIN_STACKSIZE);
-	wpi_assert(pTask);
-	pTask->Start((int) this);
+	// with the executor enabled ComponentBase has already registered us there
+
+	if(!COMPONENT_EXECUTOR_ENABLED)
+	{
+		pTask = new Task(DRIVETRAIN_TASKNAME, (FUNCPTR) &Drivetrain::StartTask,
+				DRIVETRAIN_PRIORITY, DRIVETRAIN_STACKSIZE);
+		wpi_assert(pTask);
+		pTask->Start((intptr_t)this);
+	}
 }
 
 Drivetrain::~Drivetrain()			//Destructor
@@ -71,8 +87,7 @@ void Drivetrain::OnStateChange()			//Handles state changes
 	switch(localMessage.command) {
 	case COMMAND_ROBOT_STATE_AUTONOMOUS:
 		//restore motor values
-		leftMotor->Set(left);
-		rightMotor->Set(right);
+		SetMotors(left, right);
 		//gyro->Zero();
 		//encoder->Reset();
 		//gyro should be reset by a message from autonomous
@@ -80,28 +95,32 @@ void Drivetrain::OnStateChange()			//Handles state changes
 		break;
 
 	case COMMAND_ROBOT_STATE_TEST:
-		leftMotor->Set(0.0);
-		rightMotor->Set(0.0);
+		SetMotors(0.0, 0.0);
 		break;
 
 	case COMMAND_ROBOT_STATE_TELEOPERATED:
-		leftMotor->Set(0.0);
-		rightMotor->Set(0.0);
+		SetMotors(0.0, 0.0);
 		break;
 
 	case COMMAND_ROBOT_STATE_DISABLED:
-		leftMotor->Set(0.0);
-		rightMotor->Set(0.0);
+		SetMotors(0.0, 0.0);
+		bDrivingStraight = false;
+		bTurning = false;
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
+
+		// how long from RhsRobot noticing the disable to the motors being told to stop
+		fDisableLatency = (GetMonotonicNs() - localMessage.header.uSendTime) / (float)NS_PER_MSEC;
+		fMaxDisableLatency = max(fMaxDisableLatency, fDisableLatency);
+		Telemetry::Set(disableLatencyKey, fDisableLatency);
+		Telemetry::Set(maxDisableLatencyKey, fMaxDisableLatency);
 		break;
 
 	case COMMAND_ROBOT_STATE_UNKNOWN:
-		leftMotor->Set(0.0);
-		rightMotor->Set(0.0);
+		SetMotors(0.0, 0.0);
 		break;
 
 	default:
-		leftMotor->Set(0.0);
-		rightMotor->Set(0.0);
+		SetMotors(0.0, 0.0);
 		break;
 	}
 }
@@ -114,13 +133,14 @@ void Drivetrain::Run() {
 		//speed reduction will be controlled by RhsRobot. Power curve is done with raw joystick value
 		bDrivingStraight = false;
 		bTurning = false;
-		leftMotor->Set(localMessage.params.tankDrive.left);
-		rightMotor->Set(-localMessage.params.tankDrive.right);
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
+		SetMotors(localMessage.params.tankDrive.left, -localMessage.params.tankDrive.right);
 		break;
 	case COMMAND_DRIVETRAIN_DRIVE_ARCADE:
 		//SmartDashboard::PutString("Drivetrain CMD", "DRIVETRAIN_DRIVE_ARCADE");
 		bDrivingStraight = false;
 		bTurning = false;
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
 		ArcadeDrive(localMessage.params.arcadeDrive.x,
 				localMessage.params.arcadeDrive.y);
 		break;
@@ -135,6 +155,7 @@ void Drivetrain::Run() {
 		//reset stored values
 		bDrivingStraight = false;
 		bTurning = false;
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
 		left = 0;
 		right = 0;
 		pAutoTimer->Reset();
@@ -146,10 +167,10 @@ void Drivetrain::Run() {
 		//reset all auto variables
 		bDrivingStraight = false;
 		bTurning = false;
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
 		left = 0;
 		right = 0;
-		leftMotor->Set(left);
-		rightMotor->Set(right);
+		SetMotors(left, right);
 		gyro->Zero();
 	break;
 
@@ -158,10 +179,10 @@ void Drivetrain::Run() {
 		//store sent
 		bDrivingStraight = false;
 		bTurning = false;
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
 		left = localMessage.params.tankDrive.left;
 		right = -localMessage.params.tankDrive.right;
-		leftMotor->Set(left);
-		rightMotor->Set(right);
+		SetMotors(left, right);
 		break;
 
 	case COMMAND_DRIVETRAIN_TURN:
@@ -174,21 +195,21 @@ void Drivetrain::Run() {
 		//reset all auto variables
 		bDrivingStraight = false;
 		bTurning = false;
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
 		left = 0.0;
 		right = 0.0;
-		leftMotor->Set(left);
-		rightMotor->Set(right);
+		SetMotors(left, right);
 		gyro->Zero();
 		break;
 
 	case COMMAND_DRIVETRAIN_START_DRIVE_FWD:
 		gyro->Zero();
-		#Needs more code
+		//Needs more code
 		break;
 
 	case COMMAND_DRIVETRAIN_START_DRIVE_BCK:
 		gyro->Zero();
-		#Needs more code
+		//Needs more code
 		break;
 
 	case COMMAND_DRIVETRAIN_START_KEEPALIGN:
@@ -209,30 +230,45 @@ void Drivetrain::Run() {
 		break;
 	}
 
-	if(bDrivingStraight)
-	{
-		IterateStraightDrive();
-	}
+	// closed loop behaviors only iterate on ticks so they run at DRIVETRAIN_TICK_PERIOD
 
-	if(bTurning)
+	if(wakeReason == COMPONENT_WAKE_TICK)
 	{
-		IterateTurn();
-	}
+		CheckStill();
 
-	//Put out information
-	if (pRemoteUpdateTimer->Get() > 0.2)
-	{
-		pRemoteUpdateTimer->Reset();
-		//SmartDashboard::PutBoolean("Tote Detector", toteSensor->Get());
-		//gyro reading is truncated for the sake of the CSV file.
-		SmartDashboard::PutNumber("Gyro Angle", TRUNC_THOU(gyro->GetAngle()));
+		if(bDrivingStraight)
+		{
+			IterateStraightDrive();
+		}
+
+		if(bTurning)
+		{
+			IterateTurn();
+		}
 	}
+
+	//Put out information, the telemetry task decides when it actually goes out
+	//Telemetry::SetBoolean(toteDetectorKey, toteSensor->Get());
+	//gyro reading is truncated for the dashboard, the data log keeps every sample in full
+	Telemetry::Set(gyroAngleKey, TRUNC_THOU(gyro->GetAngle()));
+}
+
+void Drivetrain::SmartDashboardUpdate() {
+	//everything we publish goes through Telemetry
+}
+
+///Sets both drive motors and logs the setpoints
+void Drivetrain::SetMotors(float fLeft, float fRight) {
+	leftMotor->Set(fLeft);
+	rightMotor->Set(fRight);
+	fLeftOutput = fLeft;
+	fRightOutput = fRight;
+	DataLog::Record(DATALOG_TYPE_DRIVE, ENDPOINT_DRIVETRAIN, fLeft, fRight);
 }
 
 void Drivetrain::ArcadeDrive(float x, float y) {
 	//TODO: add speed reduction
-	leftMotor->Set(y + x / 2);
-	rightMotor->Set(-(y - x / 2));
+	SetMotors(y + x / 2, -(y - x / 2));
 }
 void Drivetrain::MeasuredMove(float speed, float targetDist) {
 #if 0
@@ -263,8 +299,7 @@ void Drivetrain::MeasuredMove(float speed, float targetDist) {
 			right = 0;
 			isFinished = true;
 		}
-		leftMotor->Set(left);
-		rightMotor->Set(right);
+		SetMotors(left, right);
 		SmartDashboard::PutNumber("Covered Distance", coveredDist);
 		SmartDashboard::PutNumber("Remaining Distance", remainingDist);
 		SmartDashboard::PutNumber("Angle Adjustment", adjustment);
@@ -281,11 +316,10 @@ void Drivetrain::KeepAligned() {
 	float motorValue = error * turnAngleSpeedMultiplyer;
 	ABLIMIT(motorValue, turnSpeedLimit);
 
-	leftMotor->Set(motorValue);
-	rightMotor->Set(motorValue);
+	SetMotors(motorValue, motorValue);
 
-	SmartDashboard::PutNumber("Angle Error", error);
-	SmartDashboard::PutNumber("Turn Speed", motorValue);
+	Telemetry::Set(angleErrorKey, error);
+	Telemetry::Set(turnSpeedKey, motorValue);
 }
 
 void Drivetrain::Turn(float targetAngle, float timeout) {
@@ -310,24 +344,23 @@ void Drivetrain::Turn(float targetAngle, float timeout) {
 
 		ABLIMIT(motorValue, turnSpeedLimit);
 
-		leftMotor->Set(motorValue);
-		rightMotor->Set(motorValue);
+		SetMotors(motorValue, motorValue);
 
-		SmartDashboard::PutNumber("Angle Error", degreesLeft);
-		SmartDashboard::PutNumber("Turn Speed", motorValue);
+		Telemetry::Set(angleErrorKey, degreesLeft);
+		Telemetry::Set(turnSpeedKey, motorValue);
 	}
 
-	leftMotor->Set(0);
-	rightMotor->Set(0);
+	SetMotors(0, 0);
 	command = COMMAND_AUTONOMOUS_RESPONSE_OK;
 	SendCommandResponse(command);
 
-	SmartDashboard::PutNumber("Angle Error", 0.0);
-	SmartDashboard::PutNumber("Turn Speed", 0.0);
+	Telemetry::Set(angleErrorKey, 0.0);
+	Telemetry::Set(turnSpeedKey, 0.0);
 }
 
 void Drivetrain::StartStraightDrive(float speed, float time)
 {
+	StartAutoRequest();
 	pAutoTimer->Reset();
 	//DO NOT RESET THE GYRO EVER. only zeroing.
 	gyro->Zero();
@@ -349,13 +382,14 @@ void Drivetrain::IterateStraightDrive(void)
 		bDrivingStraight = false;
 		left = 0.0;
 		right = 0.0;
-		leftMotor->Set(0.0);
-		rightMotor->Set(0.0);
+		SetMotors(0.0, 0.0);
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_OK);
 	}
 }
 
 void Drivetrain::StartTurn(float angle, float time)
 {
+	StartAutoRequest();
 	pAutoTimer->Reset();
 	//DO NOT RESET THE GYRO EVER. only zeroing.
 	gyro->Zero();
@@ -369,7 +403,7 @@ void Drivetrain::StartTurn(float angle, float time)
 void Drivetrain::IterateTurn(void)
 {
 	float motorValue;
-	float degreesLeft;
+	float degreesLeft = 0.0;
 
 	if ((pAutoTimer->Get() < fTurnTime) && ISAUTO)
 	{
@@ -393,10 +427,72 @@ void Drivetrain::IterateTurn(void)
 		motorValue = 0.0;
 	}
 
-	leftMotor->Set(motorValue);
-	rightMotor->Set(motorValue);
-	SmartDashboard::PutNumber("Angle Error", 0.0);
-	SmartDashboard::PutNumber("Turn Speed", 0.0);
+	SetMotors(motorValue, motorValue);
+	Telemetry::Set(angleErrorKey, degreesLeft);
+	Telemetry::Set(turnSpeedKey, motorValue);
+
+	// like Turn(), running out of time still counts as done
+
+	if(!bTurning)
+	{
+		FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_OK);
+	}
+}
+
+/**
+ * Tells the gyro whether the robot is sitting still so it can keep learning its bias:
+ * the motors have been told to stop for a while and nothing is jolting the accelerometer.
+ */
+void Drivetrain::CheckStill(void)
+{
+	double fAccel[3] = { accelerometer.GetX(), accelerometer.GetY(), accelerometer.GetZ() };
+	double fWeight = DRIVETRAIN_TICK_PERIOD / DRIVETRAIN_ACCEL_AVERAGE;
+	uint64_t uNow = GetMonotonicNs();
+	bool bQuiet = (fabs(fLeftOutput) < DRIVETRAIN_STILL_OUTPUT) && (fabs(fRightOutput) < DRIVETRAIN_STILL_OUTPUT);
+
+	for(int i = 0; i < 3; i++)
+	{
+		if(!bAccelAveraged)
+		{
+			fAccelAverage[i] = fAccel[i];
+		}
+
+		if(fabs(fAccel[i] - fAccelAverage[i]) > DRIVETRAIN_STILL_ACCEL)
+		{
+			bQuiet = false;
+		}
+
+		fAccelAverage[i] += fWeight * (fAccel[i] - fAccelAverage[i]);
+	}
+
+	bAccelAveraged = true;
+
+	// the robot coasts and rocks for a moment after the motors stop
+
+	if(!bQuiet)
+	{
+		uMovedNs = uNow;
+	}
+
+	gyro->SetStill(uNow - uMovedNs >= SecondsToNs(DRIVETRAIN_STILL_SETTLE));
+}
+
+///Remembers who asked for the straight drive or turn just started, answering any earlier one
+void Drivetrain::StartAutoRequest(void)
+{
+	FinishAutoRequest(COMMAND_AUTONOMOUS_RESPONSE_ERROR);
+	autoRequest = localMessage.header;
+	bAutoRequestPending = true;
+}
+
+///Answers the request behind the straight drive or turn in progress, if there is one
+void Drivetrain::FinishAutoRequest(MessageCommand response)
+{
+	if(bAutoRequestPending)
+	{
+		bAutoRequestPending = false;
+		SendCommandResponse(response, autoRequest);
+	}
 }
 
 void Drivetrain::StraightDrive(float speed, float time) {
@@ -414,8 +510,7 @@ void Drivetrain::StraightDrive(float speed, float time) {
 
 	left = 0;
 	right = 0;
-	leftMotor->Set(0.0);
-	rightMotor->Set(0.0);
+	SetMotors(0.0, 0.0);
 
 	SendCommandResponse(command);
 }
@@ -451,16 +546,9 @@ void Drivetrain::StraightDriveLoop(float speed) {
 	ABLIMIT(left, 1.0);
 	ABLIMIT(right, 1.0);
 
-	leftMotor->Set(left);
-	rightMotor->Set(right);
+	SetMotors(left, right);
 
-	if (pRemoteUpdateTimer->Get() > 0.2)
-	{
-		pRemoteUpdateTimer->Reset();
-		//SmartDashboard::PutBoolean("Tote Detector", toteSensor->Get());
-		SmartDashboard::PutNumber("Angle Adjustment", adjustment);
-		SmartDashboard::PutNumber("Gyro Angle", gyro->GetAngle());
-	}
+	Telemetry::Set(angleAdjustmentKey, adjustment);
 }
 
 bool Drivetrain::GetGyroAngle()
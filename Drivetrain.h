@@ -16,6 +16,7 @@
 
 #include "ComponentBase.h"			//For ComponentBase class
 #include "ADXRS453Z.h"
+#include "Telemetry.h"				//For dashboard values set from the control loop
 
 
 const float JOYSTICK_DEADZONE = 0.10;
@@ -50,6 +51,21 @@ private:
 	float fStraightDriveTime = 0.0;
 	float fTurnAngle = 0.0;
 	float fTurnTime = 0.0;
+	///milliseconds from the disabled message being sent to the motors being stopped
+	float fDisableLatency = 0.0;
+	float fMaxDisableLatency = 0.0;
+	///what the motors were last told and the accelerometer's running average, for CheckStill()
+	float fLeftOutput = 0.0;
+	float fRightOutput = 0.0;
+	double fAccelAverage[3] = { 0.0, 0.0, 0.0 };
+	bool bAccelAveraged = false;
+	uint64_t uMovedNs = 0;
+	TelemetryKey angleErrorKey;
+	TelemetryKey turnSpeedKey;
+	TelemetryKey angleAdjustmentKey;
+	TelemetryKey gyroAngleKey;
+	TelemetryKey disableLatencyKey;
+	TelemetryKey maxDisableLatencyKey;
 
 
 	bool bFrontLoadTote = false;
@@ -57,6 +73,9 @@ private:
 	bool bKeepAligned = false;
 	bool bDrivingStraight = false;
 	bool bTurning = false;
+	///header of the autonomous command behind the straight drive or turn in progress
+	MessageHeader autoRequest;
+	bool bAutoRequestPending = false;
 
 	const float fFrontLoadSpeed = .250;
 	const float fBackLoadSpeed = -.250;
@@ -83,6 +102,8 @@ private:
 	void OnStateChange();
 	void Run();
 	void Put();//for SmartDashboard
+	void SmartDashboardUpdate();
+	void SetMotors(float, float);
 	void ArcadeDrive(float, float);
 	void MeasuredMove(float,float);
 	void Turn(float,float);
@@ -94,6 +115,9 @@ private:
 	void IterateStraightDrive(void);
 	void StartTurn(float, float);
 	void IterateTurn(void);
+	void CheckStill(void);
+	void StartAutoRequest(void);
+	void FinishAutoRequest(MessageCommand);
 };
 
 #endif			//DRIVETRAIN_H
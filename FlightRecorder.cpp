@@ -0,0 +1,220 @@
+/** \file
+ * In memory flight recorder implementation.
+ */
+
+#include "FlightRecorder.h"
+#include <stdio.h>
+#include <string.h>
+#include <signal.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "WPILib.h"
+
+//Robot
+#include "DataLog.h"
+#include "RobotParams.h"
+#include "RobotTime.h"
+#include "TaskScheduler.h"
+
+///records Write copies out of the ring per system call, on the stack of whoever dumps
+const int FLIGHT_RECORDER_CHUNK = 64;
+
+DataLogHeader *FlightRecorder::pHeader = NULL;
+const char *FlightRecorder::szDirectory = "";
+char FlightRecorder::szCrashPath[256];
+std::atomic<bool> FlightRecorder::bQueued(false);
+std::atomic<bool> FlightRecorder::bRequested(false);
+
+/**
+ * Allocates the ring and installs the signal handlers.  Called once at start up after
+ * the memory lock, so the ring is resident before anything records into it.
+ */
+bool FlightRecorder::Open(const char *szDumpDirectory, uint64_t uCapacity)
+{
+	size_t size = sizeof(DataLogHeader) + uCapacity * sizeof(DataLogRecord);
+	DataLogHeader *pNewHeader;
+	struct sigaction action;
+	const int FATAL_SIGNALS[] = { SIGSEGV, SIGBUS, SIGILL, SIGFPE, SIGABRT };
+
+	if(pHeader != NULL)
+	{
+		return(true);
+	}
+
+	// one block, header then ring, as DataLog::Append expects
+
+	pNewHeader = (DataLogHeader *)new char[size];
+	memset(pNewHeader, 0, size);
+	memcpy(pNewHeader->szMagic, DATALOG_MAGIC, sizeof(pNewHeader->szMagic));
+	pNewHeader->uVersion = DATALOG_VERSION;
+	pNewHeader->uRecordSize = sizeof(DataLogRecord);
+	pNewHeader->uCapacity = uCapacity;
+	pNewHeader->uNextRecord = 0;
+	pNewHeader->uStartTimeNs = GetMonotonicNs();
+
+	// the signal handler can't format a path, so the crash file's is made now
+
+	szDirectory = szDumpDirectory;
+	snprintf(szCrashPath, sizeof(szCrashPath), "%sflight_crash.bin", szDirectory);
+
+	__atomic_store_n(&pHeader, pNewHeader, __ATOMIC_RELEASE);
+
+	// dump once on the way down, then let the signal do what it would have done
+
+	memset(&action, 0, sizeof(action));
+	sigemptyset(&action.sa_mask);
+	action.sa_handler = &FlightRecorder::OnFatalSignal;
+	action.sa_flags = SA_RESETHAND;
+
+	for(unsigned i = 0; i < sizeof(FATAL_SIGNALS) / sizeof(FATAL_SIGNALS[0]); i++)
+	{
+		sigaction(FATAL_SIGNALS[i], &action, NULL);
+	}
+
+	action.sa_handler = &FlightRecorder::OnDumpSignal;
+	action.sa_flags = SA_RESTART;
+	sigaction(SIGUSR1, &action, NULL);
+
+	return(true);
+}
+
+///Called by DataLog::Record for every record, safe from any task at any rate
+void FlightRecorder::Record(DataLogType type, uint16_t uSource, uint64_t uTimeNs, float fValue0,
+		float fValue1, float fValue2, float fValue3)
+{
+	DataLog::Append(__atomic_load_n(&pHeader, __ATOMIC_ACQUIRE), type, uSource, uTimeNs, fValue0,
+			fValue1, fValue2, fValue3);
+}
+
+/**
+ * Has a background worker dump the recorder, safe from any task.  szReason names the
+ * file and must be a string literal.  A trigger while a dump is still queued is folded
+ * into that dump.
+ */
+void FlightRecorder::Trigger(const char *szReason)
+{
+	if(__atomic_load_n(&pHeader, __ATOMIC_ACQUIRE) == NULL)
+	{
+		return;
+	}
+
+	if(!bQueued.exchange(true))
+	{
+		TaskScheduler::GetInstance()->Submit(&FlightRecorder::DumpJob, (void *)szReason);
+	}
+}
+
+///Writes the recorder out now, this takes a while so control loops should use Trigger()
+bool FlightRecorder::Dump(const char *szReason)
+{
+	char szPath[256];
+	bool bReturn;
+
+	if(__atomic_load_n(&pHeader, __ATOMIC_ACQUIRE) == NULL)
+	{
+		return(false);
+	}
+
+	snprintf(szPath, sizeof(szPath), "%sflight_%s.bin", szDirectory, szReason);
+	bReturn = Write(szPath);
+	printf("Flight recorder %s %s\n", bReturn ? "dumped to" : "could not write", szPath);
+	return(bReturn);
+}
+
+///Run by a worker now and then, the dashboard's "Flight Recorder Dump" button asks like SIGUSR1
+void FlightRecorder::DashboardJob(void *pUnused)
+{
+	if(SmartDashboard::GetBoolean("Flight Recorder Dump", false))
+	{
+		SmartDashboard::PutBoolean("Flight Recorder Dump", false);
+		bRequested.store(true);
+	}
+}
+
+///True once each time SIGUSR1 or the dashboard has asked for a dump, the main loop polls this
+bool FlightRecorder::IsRequested()
+{
+	return(bRequested.exchange(false));
+}
+
+/**
+ * Copies the ring out as a data log while the robot keeps recording into it.  A record
+ * overwritten while we copied it, or older than FLIGHT_RECORDER_SECONDS, goes out
+ * marked torn and the export tool skips it.  Only uses calls that are safe in a signal
+ * handler.
+ */
+bool FlightRecorder::Write(const char *szPath)
+{
+	DataLogRecord chunk[FLIGHT_RECORDER_CHUNK];
+	DataLogRecord *pRecords = (DataLogRecord *)(pHeader + 1);
+	DataLogHeader header;
+	uint64_t uNow = GetMonotonicNs();
+	uint64_t uKeepNs = SecondsToNs(FLIGHT_RECORDER_SECONDS);
+	uint64_t uOldest = (uNow > uKeepNs) ? (uNow - uKeepNs) : 0;
+	uint64_t uCount;
+	uint32_t uSequence;
+	bool bReturn = true;
+	int iFile;
+
+	memcpy(&header, pHeader, sizeof(header));
+	header.uNextRecord = __atomic_load_n(&pHeader->uNextRecord, __ATOMIC_ACQUIRE);
+
+	iFile = open(szPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+	if(iFile < 0)
+	{
+		return(false);
+	}
+
+	if(write(iFile, &header, sizeof(header)) != sizeof(header))
+	{
+		bReturn = false;
+	}
+
+	for(uint64_t uSlot = 0; bReturn && (uSlot < header.uCapacity); uSlot += uCount)
+	{
+		uCount = header.uCapacity - uSlot;
+
+		if(uCount > FLIGHT_RECORDER_CHUNK)
+		{
+			uCount = FLIGHT_RECORDER_CHUNK;
+		}
+
+		for(uint64_t i = 0; i < uCount; i++)
+		{
+			DataLogRecord *pRecord = &pRecords[uSlot + i];
+
+			uSequence = __atomic_load_n(&pRecord->uSequence, __ATOMIC_ACQUIRE);
+			chunk[i] = *pRecord;
+			__atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+			if((__atomic_load_n(&pRecord->uSequence, __ATOMIC_RELAXED) != uSequence) ||
+					(chunk[i].uTimeNs < uOldest))
+			{
+				uSequence = 0;
+			}
+
+			chunk[i].uSequence = uSequence;
+		}
+
+		if(write(iFile, chunk, uCount * sizeof(DataLogRecord)) != (ssize_t)(uCount * sizeof(DataLogRecord)))
+		{
+			bReturn = false;
+		}
+	}
+
+	close(iFile);
+	return(bReturn);
+}
+
+void FlightRecorder::OnFatalSignal(int iSignal)
+{
+	Write(szCrashPath);
+	raise(iSignal);
+}
+
+void FlightRecorder::OnDumpSignal(int iSignal)
+{
+	bRequested.store(true);
+}
@@ -0,0 +1,54 @@
+/** \file
+ * In memory flight recorder declaration.
+ *
+ * Every DataLog record, messages sent and handled, robot state changes, gyro samples
+ * and motor outputs, is also written to a ring in memory laid out exactly like the data
+ * log, at the same cost: a fetch-and-add and a 32 byte copy.  It is always on and needs
+ * no file or flash bandwidth until something goes wrong.  A dump writes the last
+ * FLIGHT_RECORDER_SECONDS of the ring to FLIGHT_RECORDER_DIRECTORY/flight_<reason>.bin
+ * as a data log, so tools/DataLogExport.cpp reads it too.
+ *
+ * Dumps are asked for with Trigger(), which hands the file writing to a background
+ * worker: when autonomous fails, when the robot is disabled after running, or from the
+ * dashboard.  A fatal signal (including the SIGABRT of a failed assert()) dumps to
+ * flight_crash.bin from the signal handler itself before the program dies.
+ */
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <stdint.h>
+#include <atomic>
+
+//Robot
+#include "DataLogFormat.h"
+
+class FlightRecorder
+{
+public:
+	static bool Open(const char *szDumpDirectory, uint64_t uCapacity);
+	static void Record(DataLogType type, uint16_t uSource, uint64_t uTimeNs, float fValue0,
+			float fValue1, float fValue2, float fValue3);
+	static void Trigger(const char *szReason);
+	static bool Dump(const char *szReason);
+	static bool IsRequested();
+	static void DumpJob(void *pReason)
+	{
+		Dump((const char *)pReason);
+		bQueued.store(false);
+	}
+	static void DashboardJob(void *pUnused);
+
+private:
+	static DataLogHeader *pHeader;
+	static const char *szDirectory;
+	static char szCrashPath[256];
+	static std::atomic<bool> bQueued;
+	static std::atomic<bool> bRequested;
+
+	static bool Write(const char *szPath);
+	static void OnFatalSignal(int iSignal);
+	static void OnDumpSignal(int iSignal);
+};
+
+#endif //FLIGHT_RECORDER_H
@@ -0,0 +1,75 @@
+/** \file
+ * Gyro bias tracking filter implementation.
+ */
+
+#include "GyroBiasFilter.h"
+
+//Robot
+#include "RobotTime.h"
+
+///fWalk is deg/s per root second the bias wanders, fNoise the deg/s noise on one measurement
+GyroBiasFilter::GyroBiasFilter(double fWalk, double fNoise)
+{
+	fWalkVariance = fWalk * fWalk;
+	fNoiseVariance = fNoise * fNoise;
+	Stop();
+}
+
+///Takes calibration's estimate and how sure of it we are
+void GyroBiasFilter::Start(double fBias, double fVariance, uint64_t uTimeNs)
+{
+	this->fBias = fBias;
+	this->fVariance = fVariance;
+	uLastNs = uTimeNs;
+	bStarted = true;
+}
+
+///Until started again the bias is zero and nothing is learned
+void GyroBiasFilter::Stop()
+{
+	bStarted = false;
+	fBias = 0.0;
+	fVariance = 0.0;
+	uLastNs = 0;
+}
+
+///One raw rate measurement, it only tells us about the bias if the robot was still
+void GyroBiasFilter::Add(double fRate, uint64_t uTimeNs, bool bStill)
+{
+	double fGain;
+
+	if(!bStarted)
+	{
+		return;
+	}
+
+	// predict: the bias may have wandered since we last looked
+
+	if(uTimeNs > uLastNs)
+	{
+		fVariance += fWalkVariance * (double)(uTimeNs - uLastNs) / NS_PER_SEC;
+		uLastNs = uTimeNs;
+	}
+
+	if(bStill)
+	{
+		fGain = fVariance / (fVariance + fNoiseVariance);
+		fBias += fGain * (fRate - fBias);
+		fVariance *= (1.0 - fGain);
+	}
+}
+
+bool GyroBiasFilter::IsStarted()
+{
+	return(bStarted);
+}
+
+double GyroBiasFilter::GetBias()
+{
+	return(fBias);
+}
+
+double GyroBiasFilter::GetVariance()
+{
+	return(fVariance);
+}
@@ -0,0 +1,38 @@
+/** \file
+ * Gyro bias tracking filter declaration.
+ *
+ * A one state Kalman filter on the gyro's bias.  The bias is modelled as a random walk,
+ * so its uncertainty grows the longer it goes unmeasured, and every batch the robot is
+ * known to be still measures it directly: a still robot's raw rate is all bias plus
+ * noise.  Calibration starts it off, after that it keeps following the bias as the
+ * sensor warms up instead of freezing it.  Like GyroIntegrator it doesn't touch WPILib.
+ */
+
+#ifndef GYRO_BIAS_FILTER_H
+#define GYRO_BIAS_FILTER_H
+
+#include <stdint.h>
+
+class GyroBiasFilter
+{
+public:
+	GyroBiasFilter(double fWalk, double fNoise);
+
+	void Start(double fBias, double fVariance, uint64_t uTimeNs);
+	void Stop();
+	void Add(double fRate, uint64_t uTimeNs, bool bStill);
+
+	bool IsStarted();
+	double GetBias();
+	double GetVariance();
+
+private:
+	double fWalkVariance;			//!< (deg/s)^2 the bias may wander per second
+	double fNoiseVariance;			//!< (deg/s)^2 of one measurement
+	bool bStarted;
+	double fBias;
+	double fVariance;
+	uint64_t uLastNs;
+};
+
+#endif //GYRO_BIAS_FILTER_H
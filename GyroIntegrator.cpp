@@ -0,0 +1,107 @@
+/** \file
+ * Gyro rate integrator implementation.
+ */
+
+#include "GyroIntegrator.h"
+
+//Robot
+#include "RobotTime.h"
+
+GyroIntegrator::GyroIntegrator(GyroIntegration scheme)
+{
+	this->scheme = scheme;
+	Restart();
+}
+
+///Integrates from the previous sample up to this one, the first sample only starts the clock
+void GyroIntegrator::Add(double fRate, uint64_t uTimeNs)
+{
+	double fDt;
+	double h0;
+	double h1;
+
+	if(bHaveLast)
+	{
+		fDt = Seconds(uLastNs, uTimeNs);
+
+		switch(scheme)
+		{
+		case GYRO_INTEGRATE_RECTANGLE:
+			fCommitted += fRate * fDt;
+			break;
+
+		case GYRO_INTEGRATE_TRAPEZOID:
+			fCommitted += 0.5 * (fLastRate + fRate) * fDt;
+			break;
+
+		case GYRO_INTEGRATE_SIMPSON:
+			if(!bHalfPair)
+			{
+				bHalfPair = true;
+				fPairRate = fLastRate;
+				uPairNs = uLastNs;
+				break;
+			}
+
+			h0 = Seconds(uPairNs, uLastNs);
+			h1 = fDt;
+			bHalfPair = false;
+
+			if((h0 <= 0.0) || (h1 <= 0.0))
+			{
+				// two samples at once, there is no parabola through them
+				fCommitted += 0.5 * (fPairRate + fLastRate) * h0 + 0.5 * (fLastRate + fRate) * h1;
+				break;
+			}
+
+			fCommitted += (h0 + h1) / 6.0 * ((2.0 - h1 / h0) * fPairRate
+					+ (h0 + h1) * (h0 + h1) / (h0 * h1) * fLastRate
+					+ (2.0 - h0 / h1) * fRate);
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	bHaveLast = true;
+	fLastRate = fRate;
+	uLastNs = uTimeNs;
+}
+
+///Starts the angle again from here, the next sample still integrates from the last one
+void GyroIntegrator::Zero()
+{
+	fCommitted = 0.0;
+	bHalfPair = false;
+}
+
+///Forgets everything, the next sample starts the clock
+void GyroIntegrator::Restart()
+{
+	fCommitted = 0.0;
+	bHaveLast = false;
+	fLastRate = 0.0;
+	uLastNs = 0;
+	bHalfPair = false;
+	fPairRate = 0.0;
+	uPairNs = 0;
+}
+
+///Includes a Simpson pair's first half, as a trapezoid until the second one arrives
+double GyroIntegrator::GetAngle()
+{
+	double fAngle = fCommitted;
+
+	if(bHalfPair)
+	{
+		fAngle += 0.5 * (fPairRate + fLastRate) * Seconds(uPairNs, uLastNs);
+	}
+
+	return(fAngle);
+}
+
+double GyroIntegrator::Seconds(uint64_t uFromNs, uint64_t uToNs)
+{
+	return((double)(int64_t)(uToNs - uFromNs) / NS_PER_SEC);
+}
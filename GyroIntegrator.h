@@ -0,0 +1,52 @@
+/** \file
+ * Gyro rate integrator declaration.
+ *
+ * Turns timestamped rate samples into an angle, in double precision on the monotonic
+ * clock.  The scheme is chosen when the integrator is made: rectangle is what the gyro
+ * always did, trapezoid and Simpson fit a line or a parabola through the samples so a
+ * rate that changes between them costs less error.  Nothing here touches WPILib, so
+ * tools/GyroBench.cpp runs the same code on a laptop.
+ */
+
+#ifndef GYRO_INTEGRATOR_H
+#define GYRO_INTEGRATOR_H
+
+#include <stdint.h>
+
+typedef enum eGyroIntegration
+{
+	GYRO_INTEGRATE_RECTANGLE,		//!< each interval at the rate that ends it
+	GYRO_INTEGRATE_TRAPEZOID,		//!< each interval at the mean of its two ends
+	GYRO_INTEGRATE_SIMPSON,			//!< pairs of intervals under a parabola, unequal widths allowed
+	GYRO_INTEGRATE_LAST
+} GyroIntegration;
+
+const char *const GYRO_INTEGRATION_NAMES[GYRO_INTEGRATE_LAST] = {
+	"rectangle", "trapezoid", "simpson"
+};
+
+class GyroIntegrator
+{
+public:
+	GyroIntegrator(GyroIntegration scheme);
+
+	void Add(double fRate, uint64_t uTimeNs);
+	void Zero();
+	void Restart();
+
+	double GetAngle();
+
+private:
+	GyroIntegration scheme;
+	double fCommitted;				//!< whole intervals, or whole pairs for Simpson
+	bool bHaveLast;
+	double fLastRate;
+	uint64_t uLastNs;
+	bool bHalfPair;					//!< Simpson has one interval of a pair, it starts here
+	double fPairRate;
+	uint64_t uPairNs;
+
+	static double Seconds(uint64_t uFromNs, uint64_t uToNs);
+};
+
+#endif //GYRO_INTEGRATOR_H
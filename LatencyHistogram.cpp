@@ -0,0 +1,108 @@
+/** \file
+ * Fixed bucket latency histogram implementation.
+ */
+
+#include "LatencyHistogram.h"
+
+LatencyHistogram::LatencyHistogram()
+{
+	Reset();
+}
+
+///Adds one sample, safe to call while other tasks read the histogram
+void LatencyHistogram::Record(uint64_t uNs)
+{
+	uint64_t uMax = uMaxNs.load(std::memory_order_relaxed);
+
+	uBuckets[GetBucket(uNs / 1000)].fetch_add(1, std::memory_order_relaxed);
+	uCount.fetch_add(1, std::memory_order_relaxed);
+
+	while((uNs > uMax) &&
+			!uMaxNs.compare_exchange_weak(uMax, uNs, std::memory_order_relaxed))
+	{
+		// somebody else raised the max, try again against their value
+	}
+}
+
+void LatencyHistogram::Reset()
+{
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		uBuckets[i].store(0, std::memory_order_relaxed);
+	}
+
+	uCount.store(0, std::memory_order_relaxed);
+	uMaxNs.store(0, std::memory_order_relaxed);
+}
+
+uint32_t LatencyHistogram::GetCount()
+{
+	return(uCount.load(std::memory_order_relaxed));
+}
+
+///Returns the upper edge of the bucket holding the given percentile (0.0 - 1.0)
+float LatencyHistogram::GetPercentileUs(float fPercentile)
+{
+	uint32_t uTarget = (uint32_t)(fPercentile * GetCount() + 0.5);
+	uint32_t uSeen = 0;
+	float fMax = GetMaxUs();
+
+	if(uTarget == 0)
+	{
+		uTarget = 1;
+	}
+
+	for(int i = 0; i < HISTOGRAM_BUCKETS; i++)
+	{
+		uSeen += uBuckets[i].load(std::memory_order_relaxed);
+
+		if(uSeen >= uTarget)
+		{
+			// never claim more than the worst sample we actually saw
+
+			return((GetBucketTopUs(i) < fMax) ? (float)GetBucketTopUs(i) : fMax);
+		}
+	}
+
+	return(fMax);
+}
+
+float LatencyHistogram::GetMaxUs()
+{
+	return(uMaxNs.load(std::memory_order_relaxed) / 1000.0);
+}
+
+///Four buckets per power of two: 0-3 us get their own buckets, then 4,5,6,7, 8,10,12,14 ...
+int LatencyHistogram::GetBucket(uint64_t uUs)
+{
+	int iExponent = 0;
+	int iBucket;
+
+	if(uUs < (uint64_t)HISTOGRAM_SUB_BUCKETS)
+	{
+		return((int)uUs);
+	}
+
+	while((uUs >> (iExponent + 1)) != 0)
+	{
+		iExponent++;
+	}
+
+	iBucket = (iExponent - 1) * HISTOGRAM_SUB_BUCKETS +
+			(int)((uUs >> (iExponent - 2)) & (HISTOGRAM_SUB_BUCKETS - 1));
+
+	return((iBucket < HISTOGRAM_BUCKETS) ? iBucket : HISTOGRAM_BUCKETS - 1);
+}
+
+uint64_t LatencyHistogram::GetBucketTopUs(int iBucket)
+{
+	int iExponent;
+
+	if(iBucket < HISTOGRAM_SUB_BUCKETS)
+	{
+		return(iBucket + 1);
+	}
+
+	iExponent = iBucket / HISTOGRAM_SUB_BUCKETS + 1;
+	return((uint64_t)(HISTOGRAM_SUB_BUCKETS + 1 + iBucket % HISTOGRAM_SUB_BUCKETS) << (iExponent - 2));
+}
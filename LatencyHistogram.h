@@ -0,0 +1,40 @@
+/** \file
+ * Fixed bucket latency histogram declaration.
+ *
+ * Recording a sample is one relaxed atomic increment, so the owning task can record
+ * on every message while any other task reads percentiles.  Buckets are spaced
+ * logarithmically, four per power of two microseconds, which keeps percentiles within
+ * about 20% anywhere from 1 us to over an hour.
+ */
+
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <stdint.h>
+#include <atomic>
+
+const int HISTOGRAM_SUB_BUCKETS = 4;
+const int HISTOGRAM_BUCKETS = 32 * HISTOGRAM_SUB_BUCKETS;
+
+class LatencyHistogram
+{
+public:
+	LatencyHistogram();
+
+	void Record(uint64_t uNs);
+	void Reset();
+
+	uint32_t GetCount();
+	float GetPercentileUs(float fPercentile);
+	float GetMaxUs();
+
+private:
+	std::atomic<uint32_t> uBuckets[HISTOGRAM_BUCKETS];
+	std::atomic<uint32_t> uCount;
+	std::atomic<uint64_t> uMaxNs;
+
+	static int GetBucket(uint64_t uUs);
+	static uint64_t GetBucketTopUs(int iBucket);
+};
+
+#endif //LATENCY_HISTOGRAM_H
@@ -0,0 +1,158 @@
+/** \file
+ * Component loop deadline monitor implementation.
+ */
+
+#include "LoopMonitor.h"
+#include <stdio.h>
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotTime.h"
+
+pthread_mutex_t LoopMonitor::registryMutex = PTHREAD_MUTEX_INITIALIZER;
+std::vector<LoopMonitor *> LoopMonitor::registry;
+int LoopMonitor::iAlarms = 0;
+
+LoopMonitor::LoopMonitor(const char *szComponentName, float fPeriod, float fDeadline)
+{
+	componentName = szComponentName;
+	uPeriodNs = SecondsToNs(fPeriod);
+	uDeadlineNs = SecondsToNs(fDeadline);
+	uStartNs.store(0);
+	uPass.store(0);
+	iCommand.store(COMMAND_UNKNOWN);
+	uStalledPass = 0;
+	Reset();
+	uAlarmedMisses = 0;
+
+	pthread_mutex_lock(&registryMutex);
+	registry.push_back(this);
+	pthread_mutex_unlock(&registryMutex);
+}
+
+LoopMonitor::~LoopMonitor()
+{
+	pthread_mutex_lock(&registryMutex);
+
+	for(unsigned i = 0; i < registry.size(); i++)
+	{
+		if(registry[i] == this)
+		{
+			registry.erase(registry.begin() + i);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&registryMutex);
+}
+
+///Submitted by the main loop every LOOP_WATCHDOG_PERIOD, alarms new misses and passes still running late
+void LoopMonitor::WatchdogJob(void *pUnused)
+{
+	uint64_t uNow = GetMonotonicNs();
+
+	pthread_mutex_lock(&registryMutex);
+
+	for(unsigned i = 0; i < registry.size(); i++)
+	{
+		registry[i]->Watchdog(uNow);
+	}
+
+	pthread_mutex_unlock(&registryMutex);
+}
+
+void LoopMonitor::Begin(MessageCommand command)
+{
+	iCommand.store(command, std::memory_order_relaxed);
+	uPass.fetch_add(1, std::memory_order_relaxed);
+	uStartNs.store(GetMonotonicNs(), std::memory_order_release);
+}
+
+void LoopMonitor::End()
+{
+	uint64_t uElapsed = GetMonotonicNs() - uStartNs.load(std::memory_order_relaxed);
+
+	uStartNs.store(0, std::memory_order_release);
+
+	if(uElapsed > uDeadlineNs)
+	{
+		uLastMissNs.store(uElapsed, std::memory_order_relaxed);
+		iLastMissCommand.store(iCommand.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		uMisses.fetch_add(1, std::memory_order_release);
+	}
+
+	// a pass longer than the period means at least one tick was skipped
+
+	if(uElapsed > uPeriodNs)
+	{
+		uPeriodOverruns.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// only the component writes these, the relaxed load/store pair is enough
+
+	if(uElapsed > uLongestNs.load(std::memory_order_relaxed))
+	{
+		iLongestCommand.store(iCommand.load(std::memory_order_relaxed), std::memory_order_relaxed);
+		uLongestNs.store(uElapsed, std::memory_order_relaxed);
+	}
+}
+
+void LoopMonitor::Publish()
+{
+	SmartDashboard::PutNumber(componentName + " deadline misses", uMisses.load(std::memory_order_relaxed));
+	SmartDashboard::PutNumber(componentName + " period overruns", uPeriodOverruns.load(std::memory_order_relaxed));
+	SmartDashboard::PutNumber(componentName + " longest pass ms",
+			uLongestNs.load(std::memory_order_relaxed) / (double)NS_PER_MSEC);
+	SmartDashboard::PutString(componentName + " longest pass command",
+			GetMessageCommandName((MessageCommand)iLongestCommand.load(std::memory_order_relaxed)));
+}
+
+///Clears the counts, the dashboard alarm stays up until the next one
+void LoopMonitor::Reset()
+{
+	uMisses.store(0);
+	uPeriodOverruns.store(0);
+	uLongestNs.store(0);
+	iLongestCommand.store(COMMAND_UNKNOWN);
+	uLastMissNs.store(0);
+	iLastMissCommand.store(COMMAND_UNKNOWN);
+}
+
+void LoopMonitor::Watchdog(uint64_t uNow)
+{
+	uint64_t uStart = uStartNs.load(std::memory_order_acquire);
+	uint32_t uThisPass = uPass.load(std::memory_order_relaxed);
+	uint32_t uMissed = uMisses.load(std::memory_order_acquire);
+
+	// Reset() may have dropped the count below what we last saw
+
+	if(uMissed < uAlarmedMisses)
+	{
+		uAlarmedMisses = uMissed;
+	}
+
+	if(uMissed != uAlarmedMisses)
+	{
+		uAlarmedMisses = uMissed;
+		RaiseAlarm("took", uLastMissNs.load(std::memory_order_relaxed),
+				iLastMissCommand.load(std::memory_order_relaxed));
+	}
+
+	if((uStart != 0) && (uNow > uStart) && (uNow - uStart > uDeadlineNs) && (uThisPass != uStalledPass))
+	{
+		uStalledPass = uThisPass;
+		RaiseAlarm("stalled", uNow - uStart, iCommand.load(std::memory_order_relaxed));
+	}
+}
+
+void LoopMonitor::RaiseAlarm(const char *szWhat, uint64_t uNs, int iAlarmCommand)
+{
+	char szAlarm[128];
+
+	snprintf(szAlarm, sizeof(szAlarm), "%s %s %.0f ms in %s", componentName.c_str(), szWhat,
+			uNs / (double)NS_PER_MSEC, GetMessageCommandName((MessageCommand)iAlarmCommand));
+	printf("Loop Alarm: %s\n", szAlarm);
+	SmartDashboard::PutString("Loop Alarm", szAlarm);
+	SmartDashboard::PutNumber("Loop Alarms", ++iAlarms);
+}
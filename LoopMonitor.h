@@ -0,0 +1,63 @@
+/** \file
+ * Component loop deadline monitor declaration.
+ *
+ * Each component declares how long one pass through OnStateChange/Run may take.  The
+ * component marks the start and end of every pass; passes that overrun the deadline
+ * are counted and the longest one is kept along with the command it was handling.
+ * A pass that never ends, like a blocking drive loop, can't report itself, so the
+ * watchdog job checks every monitor from a background worker and raises the
+ * "Loop Alarm" on the dashboard while the component is still stuck.  Misses are
+ * alarmed from the watchdog too, so the component itself never prints or publishes
+ * in the middle of a pass.
+ */
+
+#ifndef LOOP_MONITOR_H
+#define LOOP_MONITOR_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+#include <vector>
+
+//Robot
+#include "RobotMessage.h"
+
+class LoopMonitor
+{
+public:
+	LoopMonitor(const char *szComponentName, float fPeriod, float fDeadline);
+	~LoopMonitor();
+
+	static void WatchdogJob(void *pUnused);
+
+	void Begin(MessageCommand command);
+	void End();
+	void Publish();
+	void Reset();
+
+private:
+	static pthread_mutex_t registryMutex;
+	static std::vector<LoopMonitor *> registry;
+	static int iAlarms;						//watchdog only
+
+	std::string componentName;
+	uint64_t uPeriodNs;
+	uint64_t uDeadlineNs;
+	std::atomic<uint64_t> uStartNs;			//0 between passes
+	std::atomic<uint32_t> uPass;
+	std::atomic<int> iCommand;
+	std::atomic<uint32_t> uMisses;
+	std::atomic<uint32_t> uPeriodOverruns;
+	std::atomic<uint64_t> uLongestNs;
+	std::atomic<int> iLongestCommand;
+	std::atomic<uint64_t> uLastMissNs;
+	std::atomic<int> iLastMissCommand;
+	uint32_t uStalledPass;					//watchdog only, so a stall alarms once
+	uint32_t uAlarmedMisses;				//watchdog only, misses already alarmed
+
+	void Watchdog(uint64_t uNow);
+	void RaiseAlarm(const char *szWhat, uint64_t uNs, int iAlarmCommand);
+};
+
+#endif //LOOP_MONITOR_H
@@ -0,0 +1,114 @@
+/** \file
+ * Per component loop phase profiler implementation.
+ */
+
+#include "LoopProfiler.h"
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotTime.h"
+
+static const char *const LOOP_PHASE_NAMES[LOOP_PHASE_LAST] = {
+	"wait",
+	"receive",
+	"state change",
+	"run",
+	"stats",
+	"dashboard"
+};
+
+LoopProfiler::LoopProfiler(const char *szComponentName)
+{
+	componentName = szComponentName;
+	uBusyNs.store(0);
+	uLastPublishNs = GetMonotonicNs();
+	uMarkNs = uLastPublishNs;
+
+	for(int i = 0; i < LOOP_PHASE_LAST; i++)
+	{
+		uPassNs[i] = 0;
+		bPhaseRan[i] = false;
+	}
+}
+
+///Starts timing from now, dropping whatever happened since the last mark
+void LoopProfiler::Restart()
+{
+	uMarkNs = GetMonotonicNs();
+}
+
+///Charges the time since the last mark to a phase
+void LoopProfiler::Mark(LoopPhase phase)
+{
+	uint64_t uNow = GetMonotonicNs();
+
+	uPassNs[phase] += uNow - uMarkNs;
+	bPhaseRan[phase] = true;
+	uMarkNs = uNow;
+}
+
+///Records the pass just finished, anything after its last mark goes to the next one
+void LoopProfiler::EndPass()
+{
+	uint64_t uBusy = 0;
+
+	for(int i = 0; i < LOOP_PHASE_LAST; i++)
+	{
+		if(bPhaseRan[i])
+		{
+			phaseTime[i].Record(uPassNs[i]);
+
+			if(i != LOOP_PHASE_WAIT)
+			{
+				uBusy += uPassNs[i];
+			}
+		}
+
+		uPassNs[i] = 0;
+		bPhaseRan[i] = false;
+	}
+
+	passTime.Record(uBusy);
+	uBusyNs.fetch_add(uBusy, std::memory_order_relaxed);
+}
+
+void LoopProfiler::Publish()
+{
+	uint64_t uNow = GetMonotonicNs();
+	std::string key;
+
+	for(int i = 0; i < LOOP_PHASE_LAST; i++)
+	{
+		if(phaseTime[i].GetCount() > 0)
+		{
+			key = componentName + " " + LOOP_PHASE_NAMES[i];
+			SmartDashboard::PutNumber(key + " p50 us", phaseTime[i].GetPercentileUs(0.50));
+			SmartDashboard::PutNumber(key + " p99 us", phaseTime[i].GetPercentileUs(0.99));
+			SmartDashboard::PutNumber(key + " max us", phaseTime[i].GetMaxUs());
+		}
+	}
+
+	SmartDashboard::PutNumber(componentName + " loop p50 us", passTime.GetPercentileUs(0.50));
+	SmartDashboard::PutNumber(componentName + " loop p99 us", passTime.GetPercentileUs(0.99));
+	SmartDashboard::PutNumber(componentName + " loop max us", passTime.GetMaxUs());
+
+	if(uNow > uLastPublishNs)
+	{
+		SmartDashboard::PutNumber(componentName + " busy %",
+				100.0 * uBusyNs.exchange(0, std::memory_order_relaxed) / (double)(uNow - uLastPublishNs));
+	}
+
+	uLastPublishNs = uNow;
+}
+
+///Starts the histograms over, at the start of each match
+void LoopProfiler::Reset()
+{
+	for(int i = 0; i < LOOP_PHASE_LAST; i++)
+	{
+		phaseTime[i].Reset();
+	}
+
+	passTime.Reset();
+}
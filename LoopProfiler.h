@@ -0,0 +1,55 @@
+/** \file
+ * Per component loop phase profiler declaration.
+ *
+ * The component marks the boundary of each phase of a pass through DoWork as it goes:
+ * waiting for something to happen, receiving it, OnStateChange, Run, handing the
+ * statistics to the background workers and the dashboard update.  Every nanosecond lands in exactly one phase.  At the end of the pass each
+ * phase that ran records its time in its own histogram, and the total of everything but
+ * the wait goes in a "loop" histogram, so the percentiles show where the time goes and
+ * "busy %" shows how much of the CPU the component takes.
+ */
+
+#ifndef LOOP_PROFILER_H
+#define LOOP_PROFILER_H
+
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+//Robot
+#include "LatencyHistogram.h"
+
+typedef enum eLoopPhase
+{
+	LOOP_PHASE_WAIT,				//!< asleep in epoll, not using the CPU
+	LOOP_PHASE_RECEIVE,				//!< polling the queues, copying the message, bookkeeping
+	LOOP_PHASE_STATE_CHANGE,		//!< OnStateChange()
+	LOOP_PHASE_RUN,					//!< Run()
+	LOOP_PHASE_STATS,				//!< trace bookkeeping, submitting stats and trace jobs
+	LOOP_PHASE_DASHBOARD,			//!< SmartDashboardUpdate()
+	LOOP_PHASE_LAST
+} LoopPhase;
+
+class LoopProfiler
+{
+public:
+	LoopProfiler(const char *szComponentName);
+
+	void Restart();
+	void Mark(LoopPhase phase);
+	void EndPass();
+	void Publish();
+	void Reset();
+
+private:
+	std::string componentName;
+	LatencyHistogram phaseTime[LOOP_PHASE_LAST];
+	LatencyHistogram passTime;
+	std::atomic<uint64_t> uBusyNs;			//everything but LOOP_PHASE_WAIT since the last publish
+	uint64_t uLastPublishNs;				//publisher only
+	uint64_t uMarkNs;						//component only, from here down
+	uint64_t uPassNs[LOOP_PHASE_LAST];
+	bool bPhaseRan[LOOP_PHASE_LAST];
+};
+
+#endif //LOOP_PROFILER_H
@@ -0,0 +1,395 @@
+/** \file
+ * Message endpoint registry implementation.
+ *
+ * Every component registers its queue when it is constructed.  Senders resolve an
+ * endpoint ID to an endpoint and may keep the pointer; endpoints are never freed.
+ */
+
+#include "MessageEndpoint.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <assert.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <sched.h>
+#include <sys/stat.h>
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotParams.h"
+#include "RobotTime.h"
+#include "DataLog.h"
+
+pthread_mutex_t MessageEndpoint::registryMutex = PTHREAD_MUTEX_INITIALIZER;
+std::atomic<MessageEndpoint *> MessageEndpoint::registry[ENDPOINT_LAST];
+
+MessageEndpoint::MessageEndpoint(MessageEndpointId id)
+{
+	const char *szQueueName = ENDPOINT_QUEUES[id];
+	std::string laneName;
+
+	assert(szQueueName != NULL);
+	this->id = id;
+	queueName = szQueueName;
+	backpressure = ENDPOINT_BACKPRESSURE[id];
+	pthread_mutex_init(&conflateMutex, NULL);
+
+	// the executor runs every component on one thread, a component waiting for another
+	// to make room would be waiting on itself
+
+	if(COMPONENT_EXECUTOR_ENABLED && (backpressure == MESSAGE_BACKPRESSURE_BLOCK))
+	{
+		backpressure = MESSAGE_BACKPRESSURE_DROP_NEWEST;
+	}
+
+	for(int i = 0; i < COMMAND_LAST; i++)
+	{
+		bLatestQueued[i] = false;
+		uOrderedAtQueue[i] = 0;
+		uRetired[i] = 0;
+	}
+
+	// opening the pipes read/write never blocks waiting for the reader to show up,
+	// and lets a sender take the oldest message back out when the pipe is full
+
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+	{
+		laneName = GetLaneName(szQueueName, (MessagePriority)i);
+		mkfifo(laneName.c_str(), 0666);
+		iPipeXmt[i] = open(laneName.c_str(), O_RDWR | O_NONBLOCK);
+		assert(iPipeXmt[i] > 0);
+		pRing[i].store(NULL);
+		uEnqueued[i].store(0);
+		uDequeued[i].store(0);
+		uDropped[i].store(0);
+		uTimedOut[i].store(0);
+		uHighWater[i].store(0);
+		uOrderedSent[i].store(0);
+	}
+}
+
+/**
+ * Called by the component that owns the queue with one ring per lane (or NULLs for
+ * pipes), the rings replace the pipes for all senders.
+ */
+MessageEndpoint *MessageEndpoint::Register(MessageEndpointId id, MessageRing **ppRings)
+{
+	MessageEndpoint *pEndpoint = Resolve(id);
+
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+	{
+		pEndpoint->pRing[i].store(ppRings[i], std::memory_order_release);
+	}
+
+	return(pEndpoint);
+}
+
+///Returns the endpoint for an ID, creating it the first time the ID is seen
+MessageEndpoint *MessageEndpoint::Resolve(MessageEndpointId id)
+{
+	MessageEndpoint *pEndpoint = registry[id].load(std::memory_order_acquire);
+
+	if(pEndpoint == NULL)
+	{
+		pthread_mutex_lock(&registryMutex);
+		pEndpoint = registry[id].load(std::memory_order_relaxed);
+
+		if(pEndpoint == NULL)
+		{
+			pEndpoint = new MessageEndpoint(id);
+			registry[id].store(pEndpoint, std::memory_order_release);
+		}
+
+		pthread_mutex_unlock(&registryMutex);
+	}
+
+	return(pEndpoint);
+}
+
+std::string MessageEndpoint::GetLaneName(const char *szQueueName, MessagePriority lane)
+{
+	std::string laneName = szQueueName;
+
+	if(lane == MESSAGE_PRIORITY_URGENT)
+	{
+		laneName += "Urgent";
+	}
+
+	return(laneName);
+}
+
+void MessageEndpoint::Send(const RobotMessage *pMessage)
+{
+	RobotMessage message = *pMessage;
+	uint32_t uOrdered;
+	bool bAlreadyQueued;
+
+	message.header.uVersion = ROBOT_MESSAGE_VERSION;
+	message.header.uSendTime = GetMonotonicNs();
+	DataLog::Record(DATALOG_TYPE_SEND, message.header.uSource, message.command, id,
+			message.header.uCorrelation);
+
+	if(!IsConflated(message.command))
+	{
+		uOrderedSent[GetMessagePriority(message.command)].fetch_add(1, std::memory_order_relaxed);
+		Enqueue(&message);
+		return;
+	}
+
+	uOrdered = uOrderedSent[GetMessagePriority(message.command)].load(std::memory_order_relaxed);
+
+	pthread_mutex_lock(&conflateMutex);
+	latest[message.command] = message;
+	bAlreadyQueued = bLatestQueued[message.command];
+
+	// something was sent behind the placeholder, delivering this value there would put
+	// it ahead of that; retire the placeholder and queue a new one behind everything
+
+	if(bAlreadyQueued && (uOrderedAtQueue[message.command] != uOrdered))
+	{
+		uRetired[message.command]++;
+		bAlreadyQueued = false;
+	}
+
+	bLatestQueued[message.command] = true;
+	uOrderedAtQueue[message.command] = uOrdered;
+	pthread_mutex_unlock(&conflateMutex);
+
+	if(!bAlreadyQueued && !Enqueue(&message))
+	{
+		// no placeholder made it into the queue, the next send has to try again
+
+		pthread_mutex_lock(&conflateMutex);
+		bLatestQueued[message.command] = false;
+		pthread_mutex_unlock(&conflateMutex);
+	}
+}
+
+/**
+ * Called by the receiver on every message it takes off the queue, swaps in the newest
+ * value.  Returns false for a retired placeholder, which the receiver throws away.
+ * Retired placeholders are always ahead of the live one in their lane.
+ */
+bool MessageEndpoint::Collect(RobotMessage *pMessage)
+{
+	bool bReturn = true;
+
+	if(((unsigned)pMessage->command >= COMMAND_LAST) || !IsConflated(pMessage->command))
+	{
+		return(bReturn);
+	}
+
+	pthread_mutex_lock(&conflateMutex);
+
+	if(uRetired[pMessage->command] > 0)
+	{
+		uRetired[pMessage->command]--;
+		bReturn = false;
+	}
+	else if(bLatestQueued[pMessage->command])
+	{
+		*pMessage = latest[pMessage->command];
+		bLatestQueued[pMessage->command] = false;
+	}
+
+	pthread_mutex_unlock(&conflateMutex);
+	return(bReturn);
+}
+
+///Called by the receiver for every message it takes off a lane, including ones it throws away
+void MessageEndpoint::Dequeued(MessagePriority lane)
+{
+	uDequeued[lane].fetch_add(1, std::memory_order_relaxed);
+}
+
+///Puts depth, high water and drop counts for each lane on the dashboard
+void MessageEndpoint::Publish()
+{
+	std::string laneName;
+	int iDepth;
+
+	for(int i = 0; i < MESSAGE_PRIORITY_LANES; i++)
+	{
+		laneName = GetLaneName(queueName.c_str(), (MessagePriority)i);
+		iDepth = (int)(uEnqueued[i].load(std::memory_order_relaxed) -
+				uDequeued[i].load(std::memory_order_relaxed));
+
+		SmartDashboard::PutNumber(laneName + " depth", (iDepth > 0) ? iDepth : 0);
+		SmartDashboard::PutNumber(laneName + " high water", uHighWater[i].load(std::memory_order_relaxed));
+		SmartDashboard::PutNumber(laneName + " dropped", uDropped[i].load(std::memory_order_relaxed));
+		SmartDashboard::PutNumber(laneName + " block timeouts", uTimedOut[i].load(std::memory_order_relaxed));
+	}
+}
+
+bool MessageEndpoint::IsConflated(MessageCommand command)
+{
+	return((backpressure == MESSAGE_BACKPRESSURE_CONFLATE) ||
+			(GetMessageDelivery(command) == MESSAGE_DELIVERY_CONFLATE));
+}
+
+/**
+ * Puts a message in its lane, applying the queue's backpressure policy if the lane is
+ * full.  Returns false if the message was dropped.
+ */
+bool MessageEndpoint::Enqueue(const RobotMessage *pMessage)
+{
+	MessagePriority lane = GetMessagePriority(pMessage->command);
+	uint32_t uDepth;
+	uint32_t uHigh;
+	uint64_t uDeadlineNs = 0;
+	bool bQueued;
+
+	// count it first so the receiver can never take out more than we put in
+
+	uDepth = uEnqueued[lane].fetch_add(1, std::memory_order_relaxed) + 1 -
+			uDequeued[lane].load(std::memory_order_relaxed);
+
+	while(!(bQueued = TryEnqueue(lane, pMessage)))
+	{
+		if(backpressure == MESSAGE_BACKPRESSURE_BLOCK)
+		{
+			if(uDeadlineNs == 0)
+			{
+				uDeadlineNs = GetMonotonicNs() + SecondsToNs(MESSAGE_BLOCK_TIMEOUT);
+			}
+
+			// a receiver that can't make room in time is stuck, drop like DROP_NEWEST
+
+			if(!WaitForRoom(lane, uDeadlineNs))
+			{
+				uTimedOut[lane].fetch_add(1, std::memory_order_relaxed);
+				break;
+			}
+		}
+		else if(backpressure == MESSAGE_BACKPRESSURE_DROP_OLDEST)
+		{
+			TryEvict(lane);
+		}
+		else
+		{
+			// a conflating queue holds one message per command, it only fills if the
+			// receiver is gone; treat it like drop newest
+			break;
+		}
+	}
+
+	if(!bQueued)
+	{
+		uEnqueued[lane].fetch_sub(1, std::memory_order_relaxed);
+		uDropped[lane].fetch_add(1, std::memory_order_relaxed);
+		return(false);
+	}
+
+	uHigh = uHighWater[lane].load(std::memory_order_relaxed);
+
+	while(((int)uDepth > (int)uHigh) &&
+			!uHighWater[lane].compare_exchange_weak(uHigh, uDepth, std::memory_order_relaxed))
+	{
+		// another sender raised it, try again against their value
+	}
+
+	return(true);
+}
+
+bool MessageEndpoint::TryEnqueue(MessagePriority lane, const RobotMessage *pMessage)
+{
+	MessageRing *pTarget = pRing[lane].load(std::memory_order_acquire);
+
+	if(pTarget)
+	{
+		return(pTarget->Push(pMessage));
+	}
+
+	// messages are smaller than PIPE_BUF so a write is all or nothing
+
+	return(write(iPipeXmt[lane], (const char*)pMessage, sizeof(RobotMessage)) == sizeof(RobotMessage));
+}
+
+///Throws away the oldest message in a lane to make room, returns false if the lane was empty
+bool MessageEndpoint::TryEvict(MessagePriority lane)
+{
+	MessageRing *pTarget = pRing[lane].load(std::memory_order_acquire);
+	RobotMessage evicted;
+	bool bEvicted;
+
+	if(pTarget)
+	{
+		bEvicted = pTarget->Pop(&evicted);
+	}
+	else
+	{
+		bEvicted = (read(iPipeXmt[lane], (char*)&evicted, sizeof(RobotMessage)) == sizeof(RobotMessage));
+	}
+
+	if(!bEvicted)
+	{
+		return(false);
+	}
+
+	uDequeued[lane].fetch_add(1, std::memory_order_relaxed);
+	uDropped[lane].fetch_add(1, std::memory_order_relaxed);
+
+	// an evicted placeholder has to let the next send queue another one, unless it was
+	// a retired one
+
+	if(((unsigned)evicted.command < COMMAND_LAST) && IsConflated(evicted.command))
+	{
+		pthread_mutex_lock(&conflateMutex);
+
+		if(uRetired[evicted.command] > 0)
+		{
+			uRetired[evicted.command]--;
+		}
+		else
+		{
+			bLatestQueued[evicted.command] = false;
+		}
+
+		pthread_mutex_unlock(&conflateMutex);
+	}
+
+	return(true);
+}
+
+/**
+ * Waits a moment for the receiver to take something off a full lane.  Returns false,
+ * without waiting, once uDeadlineNs has passed.  A ring sender sleeps rather than
+ * yields: a SCHED_FIFO sender yielding never lets a lower priority receiver on its
+ * core run.
+ */
+bool MessageEndpoint::WaitForRoom(MessagePriority lane, uint64_t uDeadlineNs)
+{
+	struct pollfd pollFd;
+	uint64_t uNow = GetMonotonicNs();
+	uint64_t uWakeNs;
+
+	if(uNow >= uDeadlineNs)
+	{
+		return(false);
+	}
+
+	if(pRing[lane].load(std::memory_order_acquire))
+	{
+		uWakeNs = uNow + SecondsToNs(MESSAGE_BLOCK_POLL);
+		SleepUntilNs((uWakeNs < uDeadlineNs) ? uWakeNs : uDeadlineNs);
+	}
+	else
+	{
+		pollFd.fd = iPipeXmt[lane];
+		pollFd.events = POLLOUT;
+		poll(&pollFd, 1, (int)((uDeadlineNs - uNow + NS_PER_MSEC - 1) / NS_PER_MSEC));
+	}
+
+	return(true);
+}
+
+MessageEndpointId MessageEndpoint::GetId()
+{
+	return(id);
+}
+
+const char *MessageEndpoint::GetQueueName()
+{
+	return(queueName.c_str());
+}
@@ -0,0 +1,83 @@
+/** \file
+ * Message endpoint registry declaration.
+ *
+ * A MessageEndpoint is a reusable handle for sending messages to one component queue.
+ * Endpoint IDs are resolved to endpoints once; after that sending is a ring push or a
+ * single write on a descriptor that stays open for the life of the robot code.  The
+ * queue behind each ID comes from ENDPOINT_QUEUES in RobotParams.h.
+ *
+ * Commands declared MESSAGE_DELIVERY_CONFLATE keep their newest value in the endpoint.
+ * Only the first unread one goes into the queue, as a placeholder that the receiver
+ * swaps for the newest value when it gets to it, so the receiver never sees a stale
+ * setpoint.  A newer value must not overtake a command sent before it, so once anything
+ * that doesn't conflate has gone into the lane behind the placeholder, the next value
+ * retires the placeholder and queues a fresh one; the receiver throws retired ones away.
+ *
+ * Each queue has one lane per MessagePriority, each with its own pipe and ring.  The
+ * urgent lane of "/tmp/qDrive" is "/tmp/qDriveUrgent".
+ *
+ * When a lane is full the queue's MessageBackpressure from ENDPOINT_BACKPRESSURE
+ * decides whether the sender waits or something is dropped.  A waiting sender gives up
+ * after MESSAGE_BLOCK_TIMEOUT and drops its message, and with the component executor
+ * nobody waits at all.  Each lane counts what went in, came out, was dropped and timed
+ * out, which gives the depth and high water gauges.
+ */
+
+#ifndef MESSAGE_ENDPOINT_H
+#define MESSAGE_ENDPOINT_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+//Robot
+#include "RobotMessage.h"
+#include "MessageRing.h"
+
+class MessageEndpoint
+{
+public:
+	static MessageEndpoint *Register(MessageEndpointId id, MessageRing **ppRings);
+	static MessageEndpoint *Resolve(MessageEndpointId id);
+	static std::string GetLaneName(const char *szQueueName, MessagePriority lane);
+
+	void Send(const RobotMessage *pMessage);
+	bool Collect(RobotMessage *pMessage);
+	void Dequeued(MessagePriority lane);
+	void Publish();
+	MessageEndpointId GetId();
+	const char *GetQueueName();
+
+private:
+	static pthread_mutex_t registryMutex;
+	static std::atomic<MessageEndpoint *> registry[ENDPOINT_LAST];
+
+	MessageEndpointId id;
+	std::string queueName;
+	MessageBackpressure backpressure;
+	std::atomic<MessageRing *> pRing[MESSAGE_PRIORITY_LANES];
+	int iPipeXmt[MESSAGE_PRIORITY_LANES];
+	pthread_mutex_t conflateMutex;
+	RobotMessage latest[COMMAND_LAST];
+	bool bLatestQueued[COMMAND_LAST];
+	uint32_t uOrderedAtQueue[COMMAND_LAST];			//!< uOrderedSent of the lane when the placeholder went in
+	uint32_t uRetired[COMMAND_LAST];				//!< retired placeholders still in the queue
+	std::atomic<uint32_t> uOrderedSent[MESSAGE_PRIORITY_LANES];		//!< messages sent that don't conflate
+
+	std::atomic<uint32_t> uEnqueued[MESSAGE_PRIORITY_LANES];
+	std::atomic<uint32_t> uDequeued[MESSAGE_PRIORITY_LANES];
+	std::atomic<uint32_t> uDropped[MESSAGE_PRIORITY_LANES];
+	std::atomic<uint32_t> uTimedOut[MESSAGE_PRIORITY_LANES];		//!< BLOCK sends that gave up, also counted as dropped
+	std::atomic<uint32_t> uHighWater[MESSAGE_PRIORITY_LANES];
+
+	MessageEndpoint(MessageEndpointId id);
+	bool IsConflated(MessageCommand command);
+	bool Enqueue(const RobotMessage *pMessage);
+	bool TryEnqueue(MessagePriority lane, const RobotMessage *pMessage);
+	bool TryEvict(MessagePriority lane);
+	bool WaitForRoom(MessagePriority lane, uint64_t uDeadlineNs);
+	~MessageEndpoint() {};
+};
+
+#endif //MESSAGE_ENDPOINT_H
@@ -0,0 +1,210 @@
+/** \file
+ * Shared memory message ring implementation.
+ *
+ * The ring is a bounded multi-producer queue.  Each slot carries a sequence number:
+ * a producer may fill a slot when its sequence equals the enqueue position, a
+ * consumer may empty it when its sequence is one past the dequeue position.  Both
+ * sides claim positions with a compare and swap so they never block each other.
+ */
+
+#include "MessageRing.h"
+#include <stdio.h>
+#include <unistd.h>
+#include <assert.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/eventfd.h>
+
+MessageRing::MessageRing(const char *szQueueName, bool bOwner)
+{
+	const char *pBaseName;
+	int iShm;
+
+	this->bOwner = bOwner;
+	pShared = NULL;
+
+	// "/tmp/qDrive" becomes the shared memory object "/qDrive.ring"
+
+	pBaseName = strrchr(szQueueName, '/');
+	shmName = (pBaseName == NULL) ? "/" : "";
+	shmName += (pBaseName == NULL) ? szQueueName : pBaseName;
+	shmName += ".ring";
+
+	if(bOwner)
+	{
+		// start from a clean ring every time the robot code is restarted
+
+		shm_unlink(shmName.c_str());
+		iShm = shm_open(shmName.c_str(), O_CREAT | O_RDWR, 0666);
+		assert(iShm >= 0);
+		ftruncate(iShm, sizeof(MessageRingShared));
+	}
+	else
+	{
+		iShm = shm_open(shmName.c_str(), O_RDWR, 0666);
+		assert(iShm >= 0);
+	}
+
+	pShared = (MessageRingShared *)mmap(NULL, sizeof(MessageRingShared),
+			PROT_READ | PROT_WRITE, MAP_SHARED, iShm, 0);
+	assert(pShared != MAP_FAILED);
+	close(iShm);
+
+	if(bOwner)
+	{
+		for(unsigned i = 0; i < MESSAGE_RING_SLOTS; i++)
+		{
+			pShared->slots[i].uSequence.store(i, std::memory_order_relaxed);
+		}
+
+		pShared->uEnqueuePos.store(0, std::memory_order_relaxed);
+		pShared->uDequeuePos.store(0, std::memory_order_relaxed);
+		pShared->iSleeping.store(0, std::memory_order_relaxed);
+		pShared->iEventFd = eventfd(0, EFD_NONBLOCK);
+		assert(pShared->iEventFd >= 0);
+		std::atomic_thread_fence(std::memory_order_release);
+	}
+}
+
+MessageRing::~MessageRing()
+{
+	if(bOwner)
+	{
+		close(pShared->iEventFd);
+	}
+
+	munmap(pShared, sizeof(MessageRingShared));
+
+	if(bOwner)
+	{
+		shm_unlink(shmName.c_str());
+	}
+}
+
+///Copies a message into the ring, returns false if the ring is full
+bool MessageRing::Push(const RobotMessage *pMessage)
+{
+	MessageRingSlot *pSlot;
+	unsigned uPos = pShared->uEnqueuePos.load(std::memory_order_relaxed);
+
+	while(true)
+	{
+		pSlot = &pShared->slots[uPos & (MESSAGE_RING_SLOTS - 1)];
+		int iDiff = (int)(pSlot->uSequence.load(std::memory_order_acquire) - uPos);
+
+		if(iDiff == 0)
+		{
+			if(pShared->uEnqueuePos.compare_exchange_weak(uPos, uPos + 1,
+					std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(iDiff < 0)
+		{
+			return(false);
+		}
+		else
+		{
+			uPos = pShared->uEnqueuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	pSlot->message = *pMessage;
+	pSlot->uSequence.store(uPos + 1, std::memory_order_release);
+	Signal();
+	return(true);
+}
+
+/**
+ * Copies the oldest message out of the ring, returns false if the ring is empty.
+ * Normally only the owner pops, but a sender evicting the oldest message to make room
+ * may race it, so positions are claimed the same way Push claims them.
+ */
+bool MessageRing::Pop(RobotMessage *pMessage)
+{
+	MessageRingSlot *pSlot;
+	unsigned uPos = pShared->uDequeuePos.load(std::memory_order_relaxed);
+
+	while(true)
+	{
+		pSlot = &pShared->slots[uPos & (MESSAGE_RING_SLOTS - 1)];
+		int iDiff = (int)(pSlot->uSequence.load(std::memory_order_acquire) - (uPos + 1));
+
+		if(iDiff == 0)
+		{
+			if(pShared->uDequeuePos.compare_exchange_weak(uPos, uPos + 1,
+					std::memory_order_relaxed))
+			{
+				break;
+			}
+		}
+		else if(iDiff < 0)
+		{
+			return(false);
+		}
+		else
+		{
+			uPos = pShared->uDequeuePos.load(std::memory_order_relaxed);
+		}
+	}
+
+	*pMessage = pSlot->message;
+	pSlot->uSequence.store(uPos + MESSAGE_RING_SLOTS, std::memory_order_release);
+	return(true);
+}
+
+/**
+ * Tells producers the owner is about to sleep on the eventfd.  Returns false if a
+ * message slipped in meanwhile, in which case the owner should not sleep at all.
+ */
+bool MessageRing::PrepareWait()
+{
+	unsigned uPos;
+
+	pShared->iSleeping.store(1, std::memory_order_seq_cst);
+
+	uPos = pShared->uDequeuePos.load(std::memory_order_relaxed);
+
+	if((int)(pShared->slots[uPos & (MESSAGE_RING_SLOTS - 1)].uSequence.load(
+			std::memory_order_seq_cst) - (uPos + 1)) >= 0)
+	{
+		pShared->iSleeping.store(0, std::memory_order_relaxed);
+		return(false);
+	}
+
+	return(true);
+}
+
+///Called by the owner once it wakes up, eats any pending eventfd wakeups
+void MessageRing::FinishWait()
+{
+	uint64_t uCount;
+
+	pShared->iSleeping.store(0, std::memory_order_relaxed);
+	read(pShared->iEventFd, &uCount, sizeof(uCount));
+}
+
+int MessageRing::GetEventFd()
+{
+	return(pShared->iEventFd);
+}
+
+void MessageRing::Signal()
+{
+	uint64_t uOne = 1;
+
+	// only pay for the system call if the owner is actually sleeping
+
+	std::atomic_thread_fence(std::memory_order_seq_cst);
+
+	if(pShared->iSleeping.load(std::memory_order_relaxed) &&
+			pShared->iSleeping.exchange(0, std::memory_order_relaxed))
+	{
+		write(pShared->iEventFd, &uOne, sizeof(uOne));
+	}
+}
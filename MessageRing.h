@@ -0,0 +1,61 @@
+/** \file
+ * Shared memory message ring declaration.
+ *
+ * A MessageRing is a fixed size ring of RobotMessage slots living in POSIX shared
+ * memory.  Any number of tasks may push messages into the ring.  The owning component
+ * pops them, and so may a sender whose queue drops the oldest message when full.
+ * Pushing and popping never enter the kernel; the eventfd is only written when the
+ * owner is actually asleep waiting for work.
+ */
+
+#ifndef MESSAGE_RING_H
+#define MESSAGE_RING_H
+
+#include <atomic>
+#include <string>
+
+//Robot
+#include "RobotMessage.h"
+
+///number of message slots in each ring, must be a power of two
+const unsigned MESSAGE_RING_SLOTS = 64;
+
+///One slot in the ring, the sequence number tells producers and the consumer who owns it
+struct MessageRingSlot {
+	std::atomic<unsigned> uSequence;
+	RobotMessage message;
+};
+
+///The part of the ring that lives in shared memory
+struct MessageRingShared {
+	std::atomic<unsigned> uEnqueuePos;
+	char padEnqueue[60];			//keep producers and the consumer on separate cache lines
+	std::atomic<unsigned> uDequeuePos;
+	std::atomic<int> iSleeping;
+	///eventfd used to wake the owner, only meaningful inside the robot process
+	int iEventFd;
+	char padDequeue[52];
+	MessageRingSlot slots[MESSAGE_RING_SLOTS];
+};
+
+class MessageRing
+{
+public:
+	MessageRing(const char *szQueueName, bool bOwner);
+	~MessageRing();
+
+	bool Push(const RobotMessage *pMessage);
+	bool Pop(RobotMessage *pMessage);
+	bool PrepareWait();
+	void FinishWait();
+	int GetEventFd();
+
+private:
+	MessageRingShared *pShared;
+	std::string shmName;
+	bool bOwner;
+
+	void Signal();
+};
+
+#endif //MESSAGE_RING_H
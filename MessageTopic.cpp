@@ -0,0 +1,128 @@
+/** \file
+ * Broadcast message topic implementation.
+ *
+ * The slot is a seqlock: the sequence is odd while a publish is in progress and
+ * readers give up if it moved while they were copying, to try again when the publish
+ * wakes them.  The payload is kept as atomic
+ * words so the copy is well defined even when it races a publish.
+ */
+
+#include "MessageTopic.h"
+#include <string.h>
+#include <unistd.h>
+#include <assert.h>
+#include <sys/eventfd.h>
+
+//Robot
+#include "RobotTime.h"
+
+pthread_mutex_t MessageTopic::registryMutex = PTHREAD_MUTEX_INITIALIZER;
+std::atomic<MessageTopic *> MessageTopic::registry[TOPIC_LAST];
+
+MessageTopic::MessageTopic()
+{
+	pthread_mutex_init(&publishMutex, NULL);
+	uSequence.store(0);
+
+	for(int i = 0; i < MESSAGE_TOPIC_WORDS; i++)
+	{
+		uWords[i].store(0);
+	}
+
+	iEventFd = eventfd(0, EFD_NONBLOCK);
+	assert(iEventFd >= 0);
+}
+
+///Returns the topic for an ID, creating it the first time the ID is seen
+MessageTopic *MessageTopic::Resolve(MessageTopicId id)
+{
+	MessageTopic *pTopic = registry[id].load(std::memory_order_acquire);
+
+	if(pTopic == NULL)
+	{
+		pthread_mutex_lock(&registryMutex);
+		pTopic = registry[id].load(std::memory_order_relaxed);
+
+		if(pTopic == NULL)
+		{
+			pTopic = new MessageTopic();
+			registry[id].store(pTopic, std::memory_order_release);
+		}
+
+		pthread_mutex_unlock(&registryMutex);
+	}
+
+	return(pTopic);
+}
+
+///Replaces the topic's message and wakes every subscriber with a single eventfd write
+void MessageTopic::Publish(const RobotMessage *pMessage)
+{
+	RobotMessage message = *pMessage;
+	uint32_t uWord;
+	uint32_t uSeq;
+	uint64_t uOne = 1;
+
+	message.header.uVersion = ROBOT_MESSAGE_VERSION;
+	message.header.uSendTime = GetMonotonicNs();
+
+	pthread_mutex_lock(&publishMutex);
+	uSeq = uSequence.load(std::memory_order_relaxed);
+	uSequence.store(uSeq + 1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	for(int i = 0; i < MESSAGE_TOPIC_WORDS; i++)
+	{
+		memcpy(&uWord, (const char*)&message + i * sizeof(uint32_t), sizeof(uint32_t));
+		uWords[i].store(uWord, std::memory_order_relaxed);
+	}
+
+	uSequence.store(uSeq + 2, std::memory_order_release);
+	pthread_mutex_unlock(&publishMutex);
+
+	write(iEventFd, &uOne, sizeof(uOne));
+}
+
+/**
+ * Copies the topic's message if it is newer than *puLastSequence, which the caller
+ * keeps between calls and should start at zero.  Returns false if nothing new, and
+ * also if a publish is in progress or overtook the copy: the publisher may be a lower
+ * priority task on the same core, so waiting for it could wait forever.  Its eventfd
+ * write once it finishes wakes the subscriber to read again.
+ */
+bool MessageTopic::Read(uint32_t *puLastSequence, RobotMessage *pMessage)
+{
+	uint32_t uWord;
+	uint32_t uBefore;
+	uint32_t uAfter;
+
+	uBefore = uSequence.load(std::memory_order_acquire);
+
+	if((uBefore == *puLastSequence) || (uBefore & 1))
+	{
+		return(false);
+	}
+
+	for(int i = 0; i < MESSAGE_TOPIC_WORDS; i++)
+	{
+		uWord = uWords[i].load(std::memory_order_relaxed);
+		memcpy((char*)pMessage + i * sizeof(uint32_t), &uWord, sizeof(uint32_t));
+	}
+
+	std::atomic_thread_fence(std::memory_order_acquire);
+	uAfter = uSequence.load(std::memory_order_relaxed);
+
+	if(uBefore != uAfter)
+	{
+		return(false);
+	}
+
+	*puLastSequence = uBefore;
+	return(true);
+}
+
+///Subscribers add this to their epoll with EPOLLET, nobody ever reads it
+int MessageTopic::GetEventFd()
+{
+	return(iEventFd);
+}
@@ -0,0 +1,48 @@
+/** \file
+ * Broadcast message topic declaration.
+ *
+ * A MessageTopic holds the latest message published to it in one sequence numbered
+ * slot.  Publishing is one slot write and one eventfd write no matter how many
+ * components subscribe.  Every subscriber's epoll watches the same eventfd edge
+ * triggered, so the kernel wakes them all together, and each one copies the slot out
+ * when it wakes.  Subscribers only ever see the newest message, which is what a mode
+ * change wants.
+ */
+
+#ifndef MESSAGE_TOPIC_H
+#define MESSAGE_TOPIC_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <atomic>
+
+//Robot
+#include "RobotMessage.h"
+
+const int MESSAGE_TOPIC_WORDS = sizeof(RobotMessage) / sizeof(uint32_t);
+
+static_assert(sizeof(RobotMessage) % sizeof(uint32_t) == 0, "topic slots copy whole words");
+
+class MessageTopic
+{
+public:
+	static MessageTopic *Resolve(MessageTopicId id);
+
+	void Publish(const RobotMessage *pMessage);
+	bool Read(uint32_t *puLastSequence, RobotMessage *pMessage);
+	int GetEventFd();
+
+private:
+	static pthread_mutex_t registryMutex;
+	static std::atomic<MessageTopic *> registry[TOPIC_LAST];
+
+	pthread_mutex_t publishMutex;
+	std::atomic<uint32_t> uSequence;
+	std::atomic<uint32_t> uWords[MESSAGE_TOPIC_WORDS];
+	int iEventFd;
+
+	MessageTopic();
+	~MessageTopic() {};
+};
+
+#endif //MESSAGE_TOPIC_H
@@ -0,0 +1,116 @@
+/** \file
+ * Per component message latency tracing implementation.
+ *
+ * The hot path is two clock reads and two atomic increments per message.  Only
+ * Publish and Dump touch strings, the dashboard or the file system.
+ */
+
+#include "MessageTrace.h"
+#include <stdio.h>
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotTime.h"
+
+MessageTrace::MessageTrace(const char *szComponentName)
+{
+	componentName = szComponentName;
+	currentCommand = COMMAND_UNKNOWN;
+	uStartTime = 0;
+}
+
+///Called as soon as a message comes off the queue
+void MessageTrace::Dequeued(const RobotMessage *pMessage)
+{
+	uStartTime = GetMonotonicNs();
+	currentCommand = pMessage->command;
+
+	if(((unsigned)currentCommand < COMMAND_LAST) && (uStartTime > pMessage->header.uSendTime))
+	{
+		queueLatency[currentCommand].Record(uStartTime - pMessage->header.uSendTime);
+	}
+}
+
+///Called when the component wakes for its periodic tick instead of a message
+void MessageTrace::Ticked()
+{
+	uStartTime = GetMonotonicNs();
+	currentCommand = COMMAND_SYSTEM_MSGTIMEOUT;
+}
+
+///Called once the component has finished handling whatever woke it
+void MessageTrace::Handled()
+{
+	if((unsigned)currentCommand < COMMAND_LAST)
+	{
+		handlerTime[currentCommand].Record(GetMonotonicNs() - uStartTime);
+	}
+}
+
+///Puts p50/p99/max for every command we have seen on the dashboard
+void MessageTrace::Publish()
+{
+	std::string key;
+
+	for(int i = 0; i < COMMAND_LAST; i++)
+	{
+		key = componentName + " " + GetMessageCommandName((MessageCommand)i);
+
+		if(queueLatency[i].GetCount() > 0)
+		{
+			SmartDashboard::PutNumber(key + " queue p50 us", queueLatency[i].GetPercentileUs(0.50));
+			SmartDashboard::PutNumber(key + " queue p99 us", queueLatency[i].GetPercentileUs(0.99));
+			SmartDashboard::PutNumber(key + " queue max us", queueLatency[i].GetMaxUs());
+		}
+
+		if(handlerTime[i].GetCount() > 0)
+		{
+			SmartDashboard::PutNumber(key + " run p50 us", handlerTime[i].GetPercentileUs(0.50));
+			SmartDashboard::PutNumber(key + " run p99 us", handlerTime[i].GetPercentileUs(0.99));
+			SmartDashboard::PutNumber(key + " run max us", handlerTime[i].GetMaxUs());
+		}
+	}
+}
+
+///Writes every histogram summary to <directory>trace_<component>.csv
+bool MessageTrace::Dump(const char *szDirectory)
+{
+	std::string fileName = std::string(szDirectory) + "trace_" + componentName + ".csv";
+	FILE *pFile = fopen(fileName.c_str(), "w");
+
+	if(pFile == NULL)
+	{
+		return(false);
+	}
+
+	fprintf(pFile, "command,queue_count,queue_p50_us,queue_p99_us,queue_max_us,"
+			"run_count,run_p50_us,run_p99_us,run_max_us\n");
+
+	for(int i = 0; i < COMMAND_LAST; i++)
+	{
+		if((queueLatency[i].GetCount() == 0) && (handlerTime[i].GetCount() == 0))
+		{
+			continue;
+		}
+
+		fprintf(pFile, "%s,%u,%0.1f,%0.1f,%0.1f,%u,%0.1f,%0.1f,%0.1f\n",
+				GetMessageCommandName((MessageCommand)i),
+				queueLatency[i].GetCount(), queueLatency[i].GetPercentileUs(0.50),
+				queueLatency[i].GetPercentileUs(0.99), queueLatency[i].GetMaxUs(),
+				handlerTime[i].GetCount(), handlerTime[i].GetPercentileUs(0.50),
+				handlerTime[i].GetPercentileUs(0.99), handlerTime[i].GetMaxUs());
+	}
+
+	fclose(pFile);
+	return(true);
+}
+
+void MessageTrace::Reset()
+{
+	for(int i = 0; i < COMMAND_LAST; i++)
+	{
+		queueLatency[i].Reset();
+		handlerTime[i].Reset();
+	}
+}
@@ -0,0 +1,41 @@
+/** \file
+ * Per component message latency tracing declaration.
+ *
+ * Each component keeps two histograms per MessageCommand: how long messages waited
+ * between MessageEndpoint::Send and being dequeued, and how long OnStateChange/Run
+ * took to handle them.  Ticks are traced as COMMAND_SYSTEM_MSGTIMEOUT handler time.
+ */
+
+#ifndef MESSAGE_TRACE_H
+#define MESSAGE_TRACE_H
+
+#include <stdint.h>
+#include <string>
+
+//Robot
+#include "RobotMessage.h"
+#include "LatencyHistogram.h"
+
+class MessageTrace
+{
+public:
+	MessageTrace(const char *szComponentName);
+
+	void Dequeued(const RobotMessage *pMessage);
+	void Ticked();
+	void Handled();
+
+	void Publish();
+	bool Dump(const char *szDirectory);
+	void Reset();
+
+private:
+	LatencyHistogram queueLatency[COMMAND_LAST];
+	LatencyHistogram handlerTime[COMMAND_LAST];
+
+	std::string componentName;
+	MessageCommand currentCommand;
+	uint64_t uStartTime;
+};
+
+#endif //MESSAGE_TRACE_H
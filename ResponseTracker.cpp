@@ -0,0 +1,101 @@
+/** \file
+ * Command response tracker implementation.
+ *
+ * Responses complete the handle whose correlation ID they echo.  A handle whose waiter
+ * gave up (timeout or a wait-any that finished elsewhere) is freed straight away; its
+ * ID is never handed out again for a long time, so a late response matches nothing
+ * and is dropped instead of completing some later command.
+ */
+
+#include "ResponseTracker.h"
+
+ResponseTracker::ResponseTracker()
+{
+	for(int i = 0; i < RESPONSE_TRACKER_SLOTS; i++)
+	{
+		slots[i].state = RESPONSE_SLOT_FREE;
+		slots[i].response = COMMAND_UNKNOWN;
+		slots[i].uCorrelation = 0;
+		slots[i].endpoint = ENDPOINT_NONE;
+	}
+
+	uNextCorrelation = 1;
+}
+
+/**
+ * Reserves a handle for a command about to be sent and fills in the correlation ID to
+ * put in its header.  Returns -1 if too many are outstanding.
+ */
+int ResponseTracker::Expect(MessageEndpointId endpoint, uint32_t *puCorrelation)
+{
+	int iHandle = -1;
+
+	for(int i = 0; i < RESPONSE_TRACKER_SLOTS; i++)
+	{
+		if(slots[i].state == RESPONSE_SLOT_FREE)
+		{
+			slots[i].state = RESPONSE_SLOT_PENDING;
+			slots[i].response = COMMAND_UNKNOWN;
+			slots[i].endpoint = endpoint;
+			slots[i].uCorrelation = uNextCorrelation;
+			*puCorrelation = uNextCorrelation;
+			iHandle = i;
+
+			// zero means "no response wanted", skip it when we wrap
+
+			if(++uNextCorrelation == 0)
+			{
+				uNextCorrelation = 1;
+			}
+
+			break;
+		}
+	}
+
+	return(iHandle);
+}
+
+/**
+ * Called from the component task when a response message arrives.  Returns false if
+ * nobody is waiting for it any more.
+ */
+bool ResponseTracker::Complete(const RobotMessage *pResponse)
+{
+	bool bMatched = false;
+
+	for(int i = 0; i < RESPONSE_TRACKER_SLOTS; i++)
+	{
+		if((slots[i].state == RESPONSE_SLOT_PENDING) &&
+				(slots[i].uCorrelation == pResponse->header.uCorrelation) &&
+				(slots[i].endpoint == pResponse->header.uSource))
+		{
+			slots[i].state = RESPONSE_SLOT_DONE;
+			slots[i].response = pResponse->command;
+			bMatched = true;
+			break;
+		}
+	}
+
+	return(bMatched);
+}
+
+///Returns true and frees the handle once its response has arrived
+bool ResponseTracker::Poll(int iHandle, MessageCommand *pResponse)
+{
+	bool bDone = false;
+
+	if(slots[iHandle].state == RESPONSE_SLOT_DONE)
+	{
+		*pResponse = slots[iHandle].response;
+		slots[iHandle].state = RESPONSE_SLOT_FREE;
+		bDone = true;
+	}
+
+	return(bDone);
+}
+
+///Gives up on a handle, a response that arrives later is dropped
+void ResponseTracker::Cancel(int iHandle)
+{
+	slots[iHandle].state = RESPONSE_SLOT_FREE;
+}
@@ -0,0 +1,52 @@
+/** \file
+ * Command response tracker declaration.
+ *
+ * Autonomous asks the tracker for a handle before it sends a command that needs a
+ * response, then polls that handle each time its task runs.  Each handle comes with a
+ * correlation ID that goes out in the command's header and comes back in the
+ * response's, so any number of commands to any number of components can be
+ * outstanding at once.  Responses are completed and collected on the Autonomous
+ * component task, so nothing ever blocks waiting for a reply and no locking is needed.
+ */
+
+#ifndef RESPONSE_TRACKER_H
+#define RESPONSE_TRACKER_H
+
+#include <stdint.h>
+
+//Robot
+#include "RobotMessage.h"
+
+///most responses we can be waiting on at once
+const int RESPONSE_TRACKER_SLOTS = 16;
+
+typedef enum eResponseSlotState
+{
+	RESPONSE_SLOT_FREE,
+	RESPONSE_SLOT_PENDING,			//!< waiting for a response
+	RESPONSE_SLOT_DONE				//!< response arrived, not yet collected
+} ResponseSlotState;
+
+struct ResponseSlot {
+	ResponseSlotState state;
+	MessageCommand response;
+	uint32_t uCorrelation;			//!< matches MessageHeader::uCorrelation of the response
+	MessageEndpointId endpoint;		//!< the component the command went to, only it may answer
+};
+
+class ResponseTracker
+{
+public:
+	ResponseTracker();
+
+	int Expect(MessageEndpointId endpoint, uint32_t *puCorrelation);
+	bool Complete(const RobotMessage *pResponse);
+	bool Poll(int iHandle, MessageCommand *pResponse);
+	void Cancel(int iHandle);
+
+private:
+	ResponseSlot slots[RESPONSE_TRACKER_SLOTS];
+	uint32_t uNextCorrelation;
+};
+
+#endif //RESPONSE_TRACKER_H
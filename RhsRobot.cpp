@@ -11,6 +11,8 @@
 
 //Robot
 #include "ComponentBase.h"
+#include "ComponentExecutor.h"
+#include "MessageTopic.h"
 #include "RobotParams.h"
 
 RhsRobot::RhsRobot() {
@@ -57,16 +59,17 @@ void RhsRobot::Init() {
 	{
 		nextComponent = ComponentSet.insert(nextComponent, autonomous);
 	}
+
+	if(COMPONENT_EXECUTOR_ENABLED)
+	{
+		ComponentExecutor::GetInstance()->Start();
+	}
 }
 
 void RhsRobot::OnStateChange() {
-	std::vector<ComponentBase *>::iterator nextComponent;
+	// one publish reaches every component at once, however many there are
 
-	for(nextComponent = ComponentSet.begin();
-			nextComponent != ComponentSet.end(); ++nextComponent)
-	{
-		(*nextComponent)->SendMessage(&robotMessage);
-	}
+	MessageTopic::Resolve(TOPIC_ROBOT_STATE)->Publish(&robotMessage);
 }
 
 void RhsRobot::Run() {
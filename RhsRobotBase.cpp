@@ -9,6 +9,8 @@
 #include "RhsRobotBase.h"			//For the local header file
 #include <assert.h>
 #include <sched.h>
+#include <time.h>
+#include <sys/resource.h>
 
 //Built-In
 
@@ -16,30 +18,60 @@
 
 //Local
 #include "RobotParams.h"			//For various robot parameters
+#include "RobotTime.h"			//For the monotonic clock
+#include "TaskJitter.h"			//For main loop wakeup jitter
+#include "LoopMonitor.h"			//For the component loop watchdog
+#include "DataLog.h"			//For the high rate data log
+#include "FlightRecorder.h"			//For dumping what led up to a fault
+#include "TaskScheduler.h"			//For task configuration and background work
+#include "Telemetry.h"			//For the load statistics
 #include "Autonomous.h"
 
 RhsRobotBase::RhsRobotBase()			//Constructor
 {
-	cpu_set_t  mask;
-	//struct sched_param param;
-
 	printf("\n\t\t%s \"%s\"\n\tVersion %s built %s at %s\n\n", ROBOT_NAME, ROBOT_NICKNAME, ROBOT_VERSION, __DATE__, __TIME__);
 
-	// run our code on the second core
+	// lock our memory and start out on the background core, so threads WPILib starts
+	// for itself stay there; StartCompetition moves the main loop where TASK_CONFIGS
+	// says once they have all been started
+
+	TaskScheduler::ConfigureProcess();
 
-	CPU_ZERO(&mask);
-	CPU_SET(1, &mask);
-	sched_setaffinity(0, sizeof(mask), &mask);
+	// after the memory lock, so the log's ring is locked in as well
+
+	if(DATALOG_ENABLED)
+	{
+		DataLog::Open(DATALOG_FILEPATH, DATALOG_RECORDS, DATALOG_BUFFER_RECORDS);
+	}
 
-    //param.sched_priority = 10;
-    //printf("did this work %d\n", sched_setscheduler(0, SCHED_FIFO, &param));
+	FlightRecorder::Open(FLIGHT_RECORDER_DIRECTORY, FLIGHT_RECORDER_RECORDS);
 
-	// what are our priority limits?
+	robotMessage.header.uSource = ENDPOINT_NONE;
+	robotMessage.header.uReply = ENDPOINT_NONE;
+	robotMessage.header.uFlags = 0;
+	robotMessage.header.uCorrelation = 0;
 
 	previousRobotState = ROBOT_STATE_UNKNOWN;
 	currentRobotState = ROBOT_STATE_UNKNOWN;
 	SmartDashboard::init();
+	SmartDashboard::PutBoolean("Flight Recorder Dump", false);
 	loop = 0;			//Initializes the loop counter
+
+	pLoadTimer = new Timer();
+	pLoadTimer->Start();
+	pWatchdogTimer = new Timer();
+	pWatchdogTimer->Start();
+	pLogTimer = new Timer();
+	pLogTimer->Start();
+	uLastCpuNs = 0;
+	uLastWallNs = GetMonotonicNs();
+	lLastSwitches = 0;
+	pLoopJitter = new TaskJitter(ROBOT_TASKNAME);
+
+	cpuKey = Telemetry::Intern("Robot CPU %", TELEMETRY_RATE_SLOW);
+	switchesKey = Telemetry::Intern("Context Switches/s", TELEMETRY_RATE_SLOW);
+	Telemetry::SetBoolean(Telemetry::Intern("Component Executor", TELEMETRY_RATE_SLOW, true),
+			COMPONENT_EXECUTOR_ENABLED);
 }
 
 RhsRobotBase::~RhsRobotBase()			//Destructor
@@ -72,14 +104,52 @@ void RhsRobotBase::StartCompetition()			//Robot's main function
 
 	Init();		//Initialize the robot
 
+	// only now, every thread started before this would have inherited the real time
+	// priority and control core, tasks that want those configure themselves
+
+	TaskScheduler::ConfigureTask(ROBOT_TASKNAME);
+
 	while(true)
 	{
+		if(pLoadTimer->Get() > LOAD_STATS_PERIOD)
+		{
+			pLoadTimer->Reset();
+			UpdateLoadStats();
+
+			// the dashboard button is read by a worker, it asks like SIGUSR1 does
+
+			TaskScheduler::GetInstance()->Submit(&FlightRecorder::DashboardJob, NULL);
+		}
+
+		if(FlightRecorder::IsRequested())
+		{
+			FlightRecorder::Trigger("demand");
+		}
+
+		// a stuck component can't report itself, have a worker look at all of them
+
+		if(pWatchdogTimer->Get() > LOOP_WATCHDOG_PERIOD)
+		{
+			pWatchdogTimer->Reset();
+			TaskScheduler::GetInstance()->Submit(&LoopMonitor::WatchdogJob, NULL);
+		}
+
+		// the data log is written to flash by a worker, never by whoever logs
+
+		if(pLogTimer->Get() > DATALOG_FLUSH_PERIOD)
+		{
+			pLogTimer->Reset();
+			DataLog::Flush();
+		}
+
 		if(!pDS->IsNewControlData())
 		{
-			Wait(0.002);
+			pLoopJitter->SleepUntil(GetMonotonicNs() + SecondsToNs(ROBOT_POLL_PERIOD));
 			continue;
 		}
 
+		LogControlData(pDS);
+
 		//Checks the current state of the robot
 		if(IsDisabled())
 		{
@@ -134,6 +204,14 @@ void RhsRobotBase::StartCompetition()			//Robot's main function
 			}
 
 			OnStateChange();			//Handles the state change
+			DataLog::Record(DATALOG_TYPE_STATE, ENDPOINT_NONE, currentRobotState, previousRobotState);
+
+			// the end of a match, or of a run on the practice field
+
+			if((currentRobotState == ROBOT_STATE_DISABLED) && (previousRobotState != ROBOT_STATE_UNKNOWN))
+			{
+				FlightRecorder::Trigger("disabled");
+			}
 		}
 
 		if(IsEnabled())
@@ -151,3 +229,79 @@ void RhsRobotBase::StartCompetition()			//Robot's main function
 		++loop;		//Increment the loop counter
 	}
 }
+
+/**
+ * Puts what the driver station just sent in the data log, everything sim/Replay.cpp
+ * needs to drive the robot code the same way again.  The mode goes last, the replay
+ * treats it as the end of the packet.
+ */
+void RhsRobotBase::LogControlData(DriverStation *pDS)
+{
+	float fAxes[2 * DATALOG_VALUES];
+	int iAxes;
+	int iMode = 0;
+
+	for(int iStick = 0; iStick < DATALOG_STICKS; iStick++)
+	{
+		iAxes = pDS->GetStickAxisCount(iStick);
+
+		for(int i = 0; i < 2 * DATALOG_VALUES; i++)
+		{
+			fAxes[i] = (i < iAxes) ? pDS->GetStickAxis(iStick, i) : 0.0;
+		}
+
+		DataLog::Record(DATALOG_TYPE_STICK, iStick, pDS->GetStickButtons(iStick),
+				(pDS->GetStickPOVCount(iStick) > 0) ? pDS->GetStickPOV(iStick, 0) : -1);
+		DataLog::Record(DATALOG_TYPE_AXES_LOW, iStick, fAxes[0], fAxes[1], fAxes[2], fAxes[3]);
+		DataLog::Record(DATALOG_TYPE_AXES_HIGH, iStick, fAxes[4], fAxes[5], fAxes[6], fAxes[7]);
+	}
+
+	if(IsEnabled())
+	{
+		iMode |= DATALOG_MODE_ENABLED;
+	}
+
+	if(IsAutonomous())
+	{
+		iMode |= DATALOG_MODE_AUTONOMOUS;
+	}
+
+	if(IsTest())
+	{
+		iMode |= DATALOG_MODE_TEST;
+	}
+
+	DataLog::Record(DATALOG_TYPE_DRIVER_STATION, ENDPOINT_NONE, iMode);
+}
+
+/**
+ * Publishes how much CPU the whole robot program used since the last call and how
+ * often it was switched out, the numbers to compare between the per task and executor
+ * component modes.
+ */
+void RhsRobotBase::UpdateLoadStats()
+{
+	struct timespec cpuTime;
+	struct rusage usage;
+	uint64_t uCpuNs;
+	uint64_t uWallNs = GetMonotonicNs();
+	long lSwitches;
+
+	clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &cpuTime);
+	getrusage(RUSAGE_SELF, &usage);
+	uCpuNs = (uint64_t)cpuTime.tv_sec * NS_PER_SEC + cpuTime.tv_nsec;
+	lSwitches = usage.ru_nvcsw + usage.ru_nivcsw;
+
+	if(uLastCpuNs != 0)
+	{
+		Telemetry::Set(cpuKey, 100.0 * (uCpuNs - uLastCpuNs) / (double)(uWallNs - uLastWallNs));
+		Telemetry::Set(switchesKey,
+				(lSwitches - lLastSwitches) * (double)NS_PER_SEC / (uWallNs - uLastWallNs));
+	}
+
+	uLastCpuNs = uCpuNs;
+	uLastWallNs = uWallNs;
+	lLastSwitches = lSwitches;
+
+	TaskScheduler::GetInstance()->Submit(&TaskScheduler::CoreLoadJob, TaskScheduler::GetInstance());
+}
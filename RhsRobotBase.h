@@ -8,10 +8,13 @@
 #define RHS_ROBOT_BASE_H
 
 #include <unistd.h>
+#include <stdint.h>
 
 //Robot
 #include <WPILib.h>			//For the RobotBase class
 #include "RobotMessage.h"
+#include "TaskJitter.h"
+#include "Telemetry.h"
 
 typedef enum eRobotOpMode
 {
@@ -47,7 +50,19 @@ private:
 
 	int loop;			//Loop counter
 
+	Timer *pLoadTimer;			//Paces UpdateLoadStats
+	Timer *pWatchdogTimer;			//Paces the component loop watchdog
+	Timer *pLogTimer;			//Paces draining the data log to its file
+	uint64_t uLastCpuNs;			//Process CPU time at the last update
+	uint64_t uLastWallNs;			//Monotonic time at the last update
+	long lLastSwitches;			//Context switches at the last update
+	TaskJitter *pLoopJitter;			//How late the main loop wakes from its poll
+	TelemetryKey cpuKey;			//Robot CPU %
+	TelemetryKey switchesKey;			//Context switches per second
+
 	void StartCompetition();			//Robot's main function
+	void UpdateLoadStats();			//Publishes CPU use and context switch rate
+	void LogControlData(DriverStation *pDS);			//Logs the driver station packet for replay
 };
 
 #endif //RHS_ROBOT_BASE_H
@@ -12,6 +12,8 @@
 #ifndef ROBOT_MESSAGE_H
 #define ROBOT_MESSAGE_H
 
+#include <stdint.h>
+
 /**
  \msc
  arcgradient = 8;
@@ -76,6 +78,44 @@ enum MessageCommand {
 
 	COMMAND_LAST                      //!< COMMAND_LAST 
 };
+
+///Short printable names for each command, used by tracing and logging
+inline const char *GetMessageCommandName(MessageCommand command)
+{
+	static const char *const szNames[] = {
+		"UNKNOWN",
+		"SYSTEM_MSGTIMEOUT",
+		"SYSTEM_OK",
+		"SYSTEM_ERROR",
+		"ROBOT_STATE_DISABLED",
+		"ROBOT_STATE_AUTONOMOUS",
+		"ROBOT_STATE_TELEOPERATED",
+		"ROBOT_STATE_TEST",
+		"ROBOT_STATE_UNKNOWN",
+		"AUTONOMOUS_RUN",
+		"AUTONOMOUS_COMPLETE",
+		"AUTONOMOUS_RESPONSE_OK",
+		"AUTONOMOUS_RESPONSE_ERROR",
+		"CHECKLIST_RUN",
+		"DRIVETRAIN_STOP",
+		"DRIVETRAIN_DRIVE_TANK",
+		"DRIVETRAIN_DRIVE_ARCADE",
+		"DRIVETRAIN_AUTO_MOVE",
+		"DRIVETRAIN_DRIVE_STRAIGHT",
+		"DRIVETRAIN_TURN",
+		"DRIVETRAIN_START_DRIVE_FWD",
+		"DRIVETRAIN_START_DRIVE_BCK",
+		"DRIVETRAIN_START_KEEPALIGN",
+		"DRIVETRAIN_STOP_KEEPALIGN",
+		"COMPONENT_TEST",
+	};
+
+	static_assert(sizeof(szNames) / sizeof(szNames[0]) == COMMAND_LAST,
+			"every MessageCommand needs a name");
+
+	return(((unsigned)command < COMMAND_LAST) ? szNames[command] : "INVALID");
+}
+
 ///Used to deliver joystick readings to Drivetrain
 struct TankDriveParams {
 	float left;
@@ -111,11 +151,148 @@ union MessageParams {
 	AutonomousParams autonomous;
 };
 
-///A structure containing a command, a set of parameters, and a reply id, sent between components
+///Layout version of RobotMessage, bump it whenever the header, commands or params change
+const uint8_t ROBOT_MESSAGE_VERSION = 1;
+
+///Numeric names for every queue, MessageEndpoint maps them to their transports
+enum MessageEndpointId {
+	ENDPOINT_NONE,						//!< not a queue, e.g. the main robot task
+	ENDPOINT_COMPONENT,
+	ENDPOINT_DRIVETRAIN,
+	ENDPOINT_AUTONOMOUS,
+	ENDPOINT_AUTOPARSER,
+	ENDPOINT_LAST
+};
+
+///Routing and timing information, messages hold no pointers so they can cross process boundaries
+struct MessageHeader {
+	uint8_t uVersion;					//!< ROBOT_MESSAGE_VERSION, stamped by MessageEndpoint::Send
+	uint8_t uSource;					//!< MessageEndpointId of the sender
+	uint8_t uReply;						//!< MessageEndpointId that responses go to
+	uint8_t uFlags;						//!< reserved, zero
+	uint32_t uCorrelation;				//!< chosen by the sender, echoed in responses, zero for no response
+	uint64_t uSendTime;					//!< CLOCK_MONOTONIC nanoseconds, stamped by MessageEndpoint::Send
+};
+
+///A structure containing a header, a command and a set of parameters, sent between components
 struct RobotMessage {
+	MessageHeader header;
 	MessageCommand command;
-	const char* replyQ;
 	MessageParams params;
 };
 
+static_assert(sizeof(RobotMessage) <= 64, "a RobotMessage should fit in one cache line");
+
+///How a queue treats a command that is sent again before the receiver has read it
+enum MessageDelivery {
+	MESSAGE_DELIVERY_FIFO,				//!< every message is delivered in order
+	MESSAGE_DELIVERY_CONFLATE			//!< a newer message replaces the unread one, only the latest is delivered
+};
+
+///Streaming setpoints conflate so a slow receiver never acts on stale joystick values
+inline MessageDelivery GetMessageDelivery(MessageCommand command)
+{
+	MessageDelivery delivery = MESSAGE_DELIVERY_FIFO;
+
+	switch(command)
+	{
+	case COMMAND_DRIVETRAIN_DRIVE_TANK:
+		delivery = MESSAGE_DELIVERY_CONFLATE;
+		break;
+	case COMMAND_DRIVETRAIN_DRIVE_ARCADE:
+		delivery = MESSAGE_DELIVERY_CONFLATE;
+		break;
+	default:
+		break;
+	}
+
+	return(delivery);
+}
+
+///What a sender does when a lane of the receiver's queue is full, selected per queue in RobotParams.h
+enum MessageBackpressure {
+	MESSAGE_BACKPRESSURE_BLOCK,			//!< wait up to MESSAGE_BLOCK_TIMEOUT for room, only for queues the main loop never sends to
+	MESSAGE_BACKPRESSURE_DROP_OLDEST,	//!< throw away the oldest queued message to make room
+	MESSAGE_BACKPRESSURE_DROP_NEWEST,	//!< throw away the message being sent
+	MESSAGE_BACKPRESSURE_CONFLATE		//!< every command conflates, so the queue never holds more than one of each
+};
+
+///Which lane of a component's queue a command travels in, the receiver always drains urgent first
+enum MessagePriority {
+	MESSAGE_PRIORITY_URGENT,			//!< state changes and stops, never stuck behind setpoints
+	MESSAGE_PRIORITY_NORMAL,			//!< everything else
+	MESSAGE_PRIORITY_LANES
+};
+
+inline MessagePriority GetMessagePriority(MessageCommand command)
+{
+	MessagePriority priority = MESSAGE_PRIORITY_NORMAL;
+
+	switch(command)
+	{
+	case COMMAND_ROBOT_STATE_DISABLED:
+		priority = MESSAGE_PRIORITY_URGENT;
+		break;
+	case COMMAND_ROBOT_STATE_AUTONOMOUS:
+		priority = MESSAGE_PRIORITY_URGENT;
+		break;
+	case COMMAND_ROBOT_STATE_TELEOPERATED:
+		priority = MESSAGE_PRIORITY_URGENT;
+		break;
+	case COMMAND_ROBOT_STATE_TEST:
+		priority = MESSAGE_PRIORITY_URGENT;
+		break;
+	case COMMAND_ROBOT_STATE_UNKNOWN:
+		priority = MESSAGE_PRIORITY_URGENT;
+		break;
+	case COMMAND_DRIVETRAIN_STOP:
+		priority = MESSAGE_PRIORITY_URGENT;
+		break;
+	default:
+		break;
+	}
+
+	return(priority);
+}
+
+///Broadcast topics, one publish reaches every component subscribed to the command
+enum MessageTopicId {
+	TOPIC_ROBOT_STATE,					//!< the ROBOT_STATE_* commands, see MessageTopic.h
+	TOPIC_LAST							//!< also means the command is not broadcast
+};
+
+inline MessageTopicId GetMessageTopic(MessageCommand command)
+{
+	MessageTopicId topic = TOPIC_LAST;
+
+	switch(command)
+	{
+	case COMMAND_ROBOT_STATE_DISABLED:
+		topic = TOPIC_ROBOT_STATE;
+		break;
+	case COMMAND_ROBOT_STATE_AUTONOMOUS:
+		topic = TOPIC_ROBOT_STATE;
+		break;
+	case COMMAND_ROBOT_STATE_TELEOPERATED:
+		topic = TOPIC_ROBOT_STATE;
+		break;
+	case COMMAND_ROBOT_STATE_TEST:
+		topic = TOPIC_ROBOT_STATE;
+		break;
+	case COMMAND_ROBOT_STATE_UNKNOWN:
+		topic = TOPIC_ROBOT_STATE;
+		break;
+	default:
+		break;
+	}
+
+	return(topic);
+}
+
+///How messages travel to a component's queue, selected per component in RobotParams.h
+enum MessageTransport {
+	MESSAGE_TRANSPORT_PIPE,				//!< named pipe in /tmp, two system calls per message
+	MESSAGE_TRANSPORT_RING				//!< lock free ring in shared memory, see MessageRing.h
+};
+
 #endif //ROBOT_MESSAGE_H
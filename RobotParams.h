@@ -4,18 +4,31 @@
  * This header contains basic parameters for the robot. All parameters must be constants with internal
  * linkage, otherwise the One Definition Rule will be violated.
  */
-#TODO: please go over these items with a knowledgeable mentor and check to see what we need/don't need
+//TODO: please go over these items with a knowledgeable mentor and check to see what we need/don't need
 #ifndef ROBOT_PARAMS_H
 #define ROBOT_PARAMS_H
 
+#include <sched.h>					//For the SCHED_FIFO and SCHED_OTHER policies
+
 //Robot
+#include "FlightRecorder.h"			//For PRINTAUTOERROR
+#include "GyroIntegrator.h"			//For the GyroIntegration schemes
 #include "JoystickLayouts.h"			//For joystick layouts
+#include "RobotMessage.h"			//For the MessageTransport and MessageEndpointId enums
 
 //Robot Params
 const char* const ROBOT_NAME =		"RhsRobot2015 Oklahoma";	//Formal name
 const char* const ROBOT_NICKNAME =   "The Blues Brothers";		//Nickname
 const char* const ROBOT_VERSION =	"2.0";						//Version
 
+//Robot Files - Where the script, logs and dumps live. A replay (sim/Replay.cpp) keeps its own
+//in the directory it is run from.
+#ifdef ROBOT_SIM
+#define ROBOT_HOME	"./"
+#else
+#define ROBOT_HOME	"/home/lvuser/"
+#endif
+
 //Robot Mode Macros - used to tell what mode the robot is in
 #define ISAUTO			RobotBase::getInstance().IsAutonomous()
 #define ISTELEOPERATED	RobotBase::getInstance().IsOperatorControl()
@@ -27,30 +40,114 @@ const char* const ROBOT_VERSION =	"2.0";						//Version
 #define ABLIMIT(a,b)		if(a > b) a = b; else if(a < -b) a = -b;
 #define TRUNC_THOU(a)		((int)(1000 * a)) * .001
 #define TRUNC_HUND(a)		((int)(100 * a)) * .01
-#define PRINTAUTOERROR		printf("Early Death! %s %i \n", __FILE__, __LINE__);
+#define PRINTAUTOERROR		do { printf("Early Death! %s %i \n", __FILE__, __LINE__); FlightRecorder::Trigger("autoerror"); } while(0)
 
 //Task Params - Defines component task priorites relative to the default priority.
+//These are only what the Task is created with, TASK_CONFIGS below sets the real time policy.
 //EXAMPLE: const int DRIVETRAIN_PRIORITY = DEFAULT_PRIORITY -2;
 const int DEFAULT_PRIORITY = 150;
 const int COMPONENT_PRIORITY 	= DEFAULT_PRIORITY;
 const int DRIVETRAIN_PRIORITY 	= DEFAULT_PRIORITY;
 const int AUTONOMOUS_PRIORITY 	= DEFAULT_PRIORITY;
-const int AUTOEXEC_PRIORITY 	= DEFAULT_PRIORITY;
 const int AUTOPARSER_PRIORITY 	= DEFAULT_PRIORITY;
+const int EXECUTOR_PRIORITY 	= DEFAULT_PRIORITY;
+const int WORKER_PRIORITY 		= DEFAULT_PRIORITY;
+const int TELEMETRY_PRIORITY 	= DEFAULT_PRIORITY;
 
 //Task Names - Used when you view the task list but used by the operating system
 //EXAMPLE: const char* DRIVETRAIN_TASKNAME = "tDrive";
 const char* const COMPONENT_TASKNAME	= "tComponent";
 const char* const DRIVETRAIN_TASKNAME	= "tDrive";
 const char* const AUTONOMOUS_TASKNAME	= "tAuto";
-const char* const AUTOEXEC_TASKNAME		= "tAutoEx";
 const char* const AUTOPARSER_TASKNAME	= "tParse";
+const char* const EXECUTOR_TASKNAME		= "tExec";
+const char* const WORKER_TASKNAME		= "tWorker";
+const char* const TELEMETRY_TASKNAME	= "tTelemetry";
+const char* const GYRO_TASKNAME			= "tADSRX543Z";
+const char* const ROBOT_TASKNAME		= "tRobot";			//the main robot loop, not a Task
 
 const int COMPONENT_STACKSIZE	= 0x10000;
 const int DRIVETRAIN_STACKSIZE	= 0x10000;
 const int AUTONOMOUS_STACKSIZE	= 0x10000;
-const int AUTOEXEC_STACKSIZE	= 0x10000;
 const int AUTOPARSER_STACKSIZE	= 0x10000;
+const int EXECUTOR_STACKSIZE	= 0x10000;
+const int WORKER_STACKSIZE		= 0x10000;
+const int TELEMETRY_STACKSIZE	= 0x10000;
+
+//Task Configuration - Every task applies its row when it starts: which cores it may run on
+//(bit 0 is core 0), its scheduling policy and, for SCHED_FIFO, its priority from 1 to 99 (higher
+//runs first; SCHED_OTHER must use 0). The latency critical loops get core 1 to themselves and
+//preempt anything else there; everything else, including the background workers that handle
+//telemetry and script loading, shares core 0 under the normal scheduler. Tasks not listed keep
+//what they started with, which is core 0 and the normal scheduler as well. Each periodic task publishes "<task> wake late" gauges.
+const unsigned CORE_CONTROL		= 0x2;
+const unsigned CORE_BACKGROUND	= 0x1;
+
+struct TaskConfig {
+	const char *szTaskName;
+	unsigned uCoreMask;
+	int iPolicy;
+	int iPriority;
+};
+
+const TaskConfig TASK_CONFIGS[] = {
+	{ GYRO_TASKNAME,		CORE_CONTROL,		SCHED_FIFO,		45 },
+	{ DRIVETRAIN_TASKNAME,	CORE_CONTROL,		SCHED_FIFO,		40 },
+	{ EXECUTOR_TASKNAME,	CORE_CONTROL,		SCHED_FIFO,		40 },
+	{ ROBOT_TASKNAME,		CORE_CONTROL,		SCHED_FIFO,		35 },
+	{ COMPONENT_TASKNAME,	CORE_BACKGROUND,	SCHED_OTHER,	0 },
+	{ AUTONOMOUS_TASKNAME,	CORE_BACKGROUND,	SCHED_OTHER,	0 },
+	{ AUTOPARSER_TASKNAME,	CORE_BACKGROUND,	SCHED_OTHER,	0 },
+	{ WORKER_TASKNAME,		CORE_BACKGROUND,	SCHED_OTHER,	0 },
+	{ TELEMETRY_TASKNAME,	CORE_BACKGROUND,	SCHED_OTHER,	0 }
+};
+
+const int TASK_CONFIG_COUNT = sizeof(TASK_CONFIGS) / sizeof(TASK_CONFIGS[0]);
+
+//Lock every page the robot program has, and will have, into RAM so a page fault never stalls a
+//real time task. Applied once, first thing when the main robot loop starts.
+const bool TASK_MEMORY_LOCKED = true;
+
+//Gyro - The gyro task reads the sensor every GYRO_SAMPLE_PERIOD, timestamping each read, and
+//integrates GYRO_BATCH_SAMPLES of them at a time, so the angle moves once per drivetrain tick.
+//Drift is the angle change per minute over GYRO_DRIFT_WINDOW seconds of the robot sitting still.
+const float GYRO_SAMPLE_PERIOD	= 0.001;
+const int GYRO_BATCH_SAMPLES	= 5;
+const GyroIntegration GYRO_INTEGRATION = GYRO_INTEGRATE_TRAPEZOID;	//tools/GyroBench.cpp compares them
+const float GYRO_STILL_RATE		= 1.0;		//deg/s, below this the robot counts as still
+const float GYRO_DRIFT_WINDOW	= 10.0;
+const float GYRO_STATS_PERIOD	= 1.0;		//seconds between dashboard updates
+
+//Gyro Bias - After calibration the bias keeps being learned, by GyroBiasFilter, from batches
+//taken while the drivetrain says the robot is still: both motors told less than
+//DRIVETRAIN_STILL_OUTPUT for DRIVETRAIN_STILL_SETTLE seconds, no accelerometer axis more than
+//DRIVETRAIN_STILL_ACCEL from its DRIVETRAIN_ACCEL_AVERAGE second running average, and the
+//gyro itself turning slower than GYRO_STILL_RATE.
+const float GYRO_BIAS_WALK				= 0.0015;	//deg/s per root second the bias may wander
+const float GYRO_BIAS_NOISE				= 0.2;		//deg/s of noise on one batch's mean rate
+const float DRIVETRAIN_STILL_OUTPUT		= 0.02;
+const float DRIVETRAIN_STILL_SETTLE		= 0.5;
+const float DRIVETRAIN_STILL_ACCEL		= 0.03;		//g
+const float DRIVETRAIN_ACCEL_AVERAGE	= 1.0;
+
+//How often the main loop checks for driver station data
+const float ROBOT_POLL_PERIOD = 0.002;
+
+//Background Workers - Two, so a slow script load can't hold up telemetry queued behind it
+const int WORKER_COUNT = 2;
+
+//Component Execution - false gives every component its own Task. true runs them all from one
+//executor Task, in construction order, every EXECUTOR_TICK_PERIOD using ring transports. Compare
+//"Robot CPU %", "Context Switches/s" and each task's "wake late" gauges between the two.
+//A replay runs everything on one thread and always uses the executor.
+#ifdef ROBOT_SIM
+const bool COMPONENT_EXECUTOR_ENABLED	= true;
+#else
+const bool COMPONENT_EXECUTOR_ENABLED	= false;
+#endif
+const float EXECUTOR_TICK_PERIOD		= 0.005;	//no longer than the shortest tick period below
+const int EXECUTOR_MESSAGES_PER_TICK	= 16;		//per component, so one busy queue can't hog the tick
+const float LOAD_STATS_PERIOD			= 1.0;		//seconds between CPU load updates
 
 //TODO change these variables throughout the code to PIPE or whatever instead  of QUEUE
 //Queue Names - Used when you want to open the message queue for any task
@@ -61,6 +158,82 @@ const char* const DRIVETRAIN_QUEUE 	= "/tmp/qDrive";
 const char* const AUTONOMOUS_QUEUE 	= "/tmp/qAuto";
 const char* const AUTOPARSER_QUEUE 	= "/tmp/qParse";
 
+//Endpoint Queues - The queue behind each MessageEndpointId, in enum order
+const char* const ENDPOINT_QUEUES[ENDPOINT_LAST] = {
+	NULL,					//ENDPOINT_NONE
+	COMPONENT_QUEUE,		//ENDPOINT_COMPONENT
+	DRIVETRAIN_QUEUE,		//ENDPOINT_DRIVETRAIN
+	AUTONOMOUS_QUEUE,		//ENDPOINT_AUTONOMOUS
+	AUTOPARSER_QUEUE		//ENDPOINT_AUTOPARSER
+};
+
+//Queue Transports - Selects how messages reach each component. The named pipe is still read by
+//ring components so anything that writes the pipe directly keeps working.
+const MessageTransport COMPONENT_TRANSPORT	= MESSAGE_TRANSPORT_PIPE;
+const MessageTransport DRIVETRAIN_TRANSPORT	= MESSAGE_TRANSPORT_RING;
+const MessageTransport AUTONOMOUS_TRANSPORT	= MESSAGE_TRANSPORT_RING;
+
+//Queue Backpressure - What senders do when a queue is full because its component is stuck.
+//Nothing the main loop sends to may BLOCK. Autonomous only hears from component tasks and
+//should not lose a response, but a BLOCK sender gives up after MESSAGE_BLOCK_TIMEOUT and
+//drops the message, and with COMPONENT_EXECUTOR_ENABLED BLOCK queues drop newest instead.
+const MessageBackpressure ENDPOINT_BACKPRESSURE[ENDPOINT_LAST] = {
+	MESSAGE_BACKPRESSURE_DROP_NEWEST,	//ENDPOINT_NONE
+	MESSAGE_BACKPRESSURE_DROP_OLDEST,	//ENDPOINT_COMPONENT
+	MESSAGE_BACKPRESSURE_DROP_OLDEST,	//ENDPOINT_DRIVETRAIN
+	MESSAGE_BACKPRESSURE_BLOCK,			//ENDPOINT_AUTONOMOUS
+	MESSAGE_BACKPRESSURE_DROP_NEWEST	//ENDPOINT_AUTOPARSER
+};
+const float MESSAGE_BLOCK_TIMEOUT	= 0.005;	//longest a BLOCK sender waits for room
+const float MESSAGE_BLOCK_POLL		= 0.0001;	//how often a ring sender looks again
+
+//Tick Periods - How often (seconds) each component's Run() is called when no message arrives.
+//Closed loop behaviors only iterate on these ticks so they run at a fixed rate.
+const float COMPONENT_TICK_PERIOD	= 0.040;
+const float DRIVETRAIN_TICK_PERIOD	= 0.005;
+const float AUTONOMOUS_TICK_PERIOD	= 0.010;	//script DELAYs end on a tick
+
+//Deadlines - The longest (seconds) one pass through a component's OnStateChange/Run may take.
+//Longer passes count as "deadline misses", and a pass still running past its deadline raises
+//the dashboard "Loop Alarm" with the command it is stuck in. The watchdog looks every
+//LOOP_WATCHDOG_PERIOD, so shorter stalls are only caught once they finish.
+const float COMPONENT_DEADLINE		= 0.010;
+const float DRIVETRAIN_DEADLINE		= 0.002;
+const float AUTONOMOUS_DEADLINE		= 0.010;
+const float LOOP_WATCHDOG_PERIOD	= 0.1;
+
+//Telemetry - Control loops set values through Telemetry and never call SmartDashboard themselves.
+//Each key is interned with one of the rates below, the least time between two updates of it.
+const int TELEMETRY_SLOTS				= 128;
+const float TELEMETRY_PUBLISH_PERIOD	= 0.02;		//how often the publisher looks for changes
+const float TELEMETRY_RATE_FAST			= 0.05;
+const float TELEMETRY_RATE_NORMAL		= 0.2;
+const float TELEMETRY_RATE_SLOW			= 1.0;
+
+//Data Log - Gyro samples, drive setpoints and message events at full rate, in a ring file that
+//holds the last DATALOG_RECORDS of them (32 bytes each). The previous run is kept as .prev.
+//Records go to a ring in memory first, which a worker drains to the file every DATALOG_FLUSH_PERIOD.
+const bool DATALOG_ENABLED				= true;
+const char* const DATALOG_FILEPATH		= ROBOT_HOME "datalog.bin";
+const int DATALOG_RECORDS				= 262144;	//about three and a half minutes of gyro samples and batches
+const int DATALOG_BUFFER_RECORDS		= 16384;	//512 KB, about thirteen seconds, many drains even on a busy flash
+const float DATALOG_FLUSH_PERIOD		= 0.1;
+const int DATALOG_STICKS				= 1;		//joysticks logged with each driver station packet, for replay
+
+//Flight Recorder - The same records kept in memory, written out as flight_<reason>.bin when
+//autonomous fails (PRINTAUTOERROR), on a crash, when the robot is disabled after running, or
+//when the dashboard's "Flight Recorder Dump" button or a SIGUSR1 asks. Always on.
+const char* const FLIGHT_RECORDER_DIRECTORY	= ROBOT_HOME;
+const int FLIGHT_RECORDER_RECORDS			= 65536;	//2 MB, more than FLIGHT_RECORDER_SECONDS holds
+const float FLIGHT_RECORDER_SECONDS			= 10.0;		//how far back a dump goes
+
+//Message Statistics - Queue depth, high water and drop gauges plus, if tracing is enabled,
+//per command queue latency and Run() time histograms for every component.
+//Recording is a couple of atomic increments so it can stay on during matches.
+const bool MESSAGE_TRACE_ENABLED			= true;
+const float MESSAGE_STATS_PUBLISH_PERIOD	= 1.0;				//seconds between dashboard updates
+const char* const MESSAGE_TRACE_DIRECTORY	= ROBOT_HOME;	//trace_<component>.csv written on disable
+
 //PWM Channels - Assigns names to PWM ports 1-10 on the Roborio
 //EXAMPLE: const int PWM_DRIVETRAIN_FRONT_LEFT_MOTOR = 1;
 const int PWM_DRIVETRAIN_LEFT_MOTOR = 1;
@@ -0,0 +1,67 @@
+/** \file
+ * Monotonic clock helpers.
+ *
+ * WPILib's Timer is fine for behaviours measured in seconds; anything that measures
+ * microseconds or schedules periodic work should use these instead.  A ROBOT_SIM build
+ * (sim/Replay.cpp) runs on the replay's virtual clock instead of the real one.
+ */
+
+#ifndef ROBOT_TIME_H
+#define ROBOT_TIME_H
+
+#include <stdint.h>
+#include <time.h>
+#include <errno.h>
+
+const uint64_t NS_PER_SEC = 1000000000ULL;
+const uint64_t NS_PER_MSEC = 1000000ULL;
+const uint64_t NS_PER_USEC = 1000ULL;
+
+#ifdef ROBOT_SIM
+uint64_t SimGetTimeNs();
+void SimSleepUntil(uint64_t uWakeNs);
+#endif
+
+///Nanoseconds since boot, never jumps when the wall clock is set
+inline uint64_t GetMonotonicNs()
+{
+#ifdef ROBOT_SIM
+	return(SimGetTimeNs());
+#else
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return((uint64_t)now.tv_sec * NS_PER_SEC + (uint64_t)now.tv_nsec);
+#endif
+}
+
+inline uint64_t SecondsToNs(float fSeconds)
+{
+	return((uint64_t)((double)fSeconds * NS_PER_SEC));
+}
+
+inline struct timespec NsToTimespec(uint64_t uNs)
+{
+	struct timespec ts;
+
+	ts.tv_sec = (time_t)(uNs / NS_PER_SEC);
+	ts.tv_nsec = (long)(uNs % NS_PER_SEC);
+	return(ts);
+}
+
+///Sleeps to an absolute time on the monotonic clock
+inline void SleepUntilNs(uint64_t uWakeNs)
+{
+#ifdef ROBOT_SIM
+	SimSleepUntil(uWakeNs);
+#else
+	struct timespec wakeTime = NsToTimespec(uWakeNs);
+
+	while(clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeTime, NULL) == EINTR)
+	{
+		// interrupted by a signal, the deadline hasn't moved
+	}
+#endif
+}
+
+#endif //ROBOT_TIME_H
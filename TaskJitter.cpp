@@ -0,0 +1,49 @@
+/** \file
+ * Task wakeup jitter measurement implementation.
+ */
+
+#include "TaskJitter.h"
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotTime.h"
+#include "TaskScheduler.h"
+
+TaskJitter::TaskJitter(const char *szTaskName)
+{
+	taskName = szTaskName;
+	TaskScheduler::GetInstance()->Watch(this);
+}
+
+TaskJitter::~TaskJitter()
+{
+	TaskScheduler::GetInstance()->Unwatch(this);
+}
+
+///Records how long after uScheduledNs the task actually started running
+void TaskJitter::Woke(uint64_t uScheduledNs)
+{
+	uint64_t uNow = GetMonotonicNs();
+
+	lateness.Record((uNow > uScheduledNs) ? (uNow - uScheduledNs) : 0);
+}
+
+///Sleeps to an absolute time on the monotonic clock and records how late we woke
+void TaskJitter::SleepUntil(uint64_t uWakeNs)
+{
+	SleepUntilNs(uWakeNs);
+	Woke(uWakeNs);
+}
+
+void TaskJitter::Publish()
+{
+	SmartDashboard::PutNumber(taskName + " wake late p50 us", lateness.GetPercentileUs(0.50));
+	SmartDashboard::PutNumber(taskName + " wake late p99 us", lateness.GetPercentileUs(0.99));
+	SmartDashboard::PutNumber(taskName + " wake late max us", lateness.GetMaxUs());
+}
+
+void TaskJitter::Reset()
+{
+	lateness.Reset();
+}
@@ -0,0 +1,35 @@
+/** \file
+ * Task wakeup jitter measurement declaration.
+ *
+ * A periodic task tells its TaskJitter when it meant to wake up each time it runs and
+ * the difference to when it actually got the CPU goes into a histogram.  Every
+ * TaskJitter registers with the TaskScheduler, which publishes them all from the
+ * background workers alongside the core load.
+ */
+
+#ifndef TASK_JITTER_H
+#define TASK_JITTER_H
+
+#include <stdint.h>
+#include <string>
+
+//Robot
+#include "LatencyHistogram.h"
+
+class TaskJitter
+{
+public:
+	TaskJitter(const char *szTaskName);
+	~TaskJitter();
+
+	void Woke(uint64_t uScheduledNs);
+	void SleepUntil(uint64_t uWakeNs);
+	void Publish();
+	void Reset();
+
+private:
+	std::string taskName;
+	LatencyHistogram lateness;
+};
+
+#endif //TASK_JITTER_H
@@ -0,0 +1,329 @@
+/** \file
+ * Task placement and background worker pool implementation.
+ */
+
+#include "TaskScheduler.h"
+#include <stdio.h>
+#include <string.h>
+#include <sched.h>
+#include <sys/mman.h>
+
+//Robot
+#include "TaskJitter.h"
+
+TaskScheduler::TaskScheduler()
+{
+	pthread_mutex_init(&sleepMutex, NULL);
+	pthread_cond_init(&workCond, NULL);
+	pthread_mutex_init(&jitterMutex, NULL);
+	iPending.store(0);
+	uNextWorker.store(0);
+	uSteals.store(0);
+
+	for(int i = 0; i < SCHEDULER_MAX_CORES; i++)
+	{
+		ullLastBusy[i] = 0;
+		ullLastTotal[i] = 0;
+	}
+
+	for(int i = 0; i < WORKER_COUNT; i++)
+	{
+		workers[i].pScheduler = this;
+		workers[i].iIndex = i;
+		pthread_mutex_init(&workers[i].mutex, NULL);
+	}
+
+#ifndef ROBOT_SIM
+	for(int i = 0; i < WORKER_COUNT; i++)
+	{
+		workers[i].pTask = new Task(WORKER_TASKNAME, (FUNCPTR) &TaskScheduler::StartWorker,
+				WORKER_PRIORITY, WORKER_STACKSIZE);
+		wpi_assert(workers[i].pTask);
+		workers[i].pTask->Start((intptr_t)&workers[i]);
+	}
+#endif
+}
+
+TaskScheduler *TaskScheduler::GetInstance()
+{
+	static TaskScheduler scheduler;
+
+	return(&scheduler);
+}
+
+/**
+ * Locks every page the program has and will have into RAM and puts the calling task on
+ * the background cores under the normal scheduler.  The main robot loop calls it first
+ * thing, before anything allocates what a real time task will touch or starts a thread,
+ * so every thread that isn't listed in TASK_CONFIGS inherits the background placement.
+ */
+void TaskScheduler::ConfigureProcess()
+{
+	cpu_set_t mask;
+	struct sched_param param;
+
+#ifdef ROBOT_SIM
+	// a replay must not pin the host's memory or move its threads
+
+	return;
+#endif
+
+	if(TASK_MEMORY_LOCKED && (mlockall(MCL_CURRENT | MCL_FUTURE) != 0))
+	{
+		printf("%s could not lock memory\n", ROBOT_TASKNAME);
+	}
+
+	CPU_ZERO(&mask);
+
+	for(int iCore = 0; iCore < SCHEDULER_MAX_CORES; iCore++)
+	{
+		if(CORE_BACKGROUND & (1 << iCore))
+		{
+			CPU_SET(iCore, &mask);
+		}
+	}
+
+	if(sched_setaffinity(0, sizeof(mask), &mask) != 0)
+	{
+		printf("%s could not be placed on cores 0x%x\n", ROBOT_TASKNAME, CORE_BACKGROUND);
+	}
+
+	param.sched_priority = 0;
+	pthread_setschedparam(pthread_self(), SCHED_OTHER, &param);
+}
+
+/**
+ * Moves the calling task onto the cores TASK_CONFIGS gives it and switches it to the
+ * policy and priority listed there.  Tasks not listed stay as they are.  A new thread
+ * inherits its creator's placement, so the main robot loop configures itself only once
+ * everything it starts has been started, or threads WPILib starts for itself would run
+ * at its real time priority on the control core.
+ */
+void TaskScheduler::ConfigureTask(const char *szTaskName)
+{
+	cpu_set_t mask;
+	struct sched_param param;
+	int iError;
+
+#ifdef ROBOT_SIM
+	// a replay runs every task on one host thread, flat out, and must not take over the host
+
+	return;
+#endif
+
+	for(int i = 0; i < TASK_CONFIG_COUNT; i++)
+	{
+		if(strcmp(TASK_CONFIGS[i].szTaskName, szTaskName) != 0)
+		{
+			continue;
+		}
+
+		CPU_ZERO(&mask);
+
+		for(int iCore = 0; iCore < SCHEDULER_MAX_CORES; iCore++)
+		{
+			if(TASK_CONFIGS[i].uCoreMask & (1 << iCore))
+			{
+				CPU_SET(iCore, &mask);
+			}
+		}
+
+		if(sched_setaffinity(0, sizeof(mask), &mask) != 0)
+		{
+			printf("%s could not be placed on cores 0x%x\n", szTaskName, TASK_CONFIGS[i].uCoreMask);
+		}
+
+		param.sched_priority = TASK_CONFIGS[i].iPriority;
+		iError = pthread_setschedparam(pthread_self(), TASK_CONFIGS[i].iPolicy, &param);
+
+		if(iError != 0)
+		{
+			printf("%s could not be given policy %d priority %d: %s\n", szTaskName,
+					TASK_CONFIGS[i].iPolicy, TASK_CONFIGS[i].iPriority, strerror(iError));
+		}
+
+		break;
+	}
+}
+
+/**
+ * Queues a job for the background workers, it runs on some worker soon but in no fixed
+ * order.  A replay has no workers, the job runs before Submit returns so it happens at
+ * the same point every time.
+ */
+void TaskScheduler::Submit(WorkFunction pFunction, void *pContext)
+{
+#ifdef ROBOT_SIM
+	pFunction(pContext);
+	return;
+#endif
+
+	SchedulerWorker *pWorker = &workers[uNextWorker.fetch_add(1, std::memory_order_relaxed) % WORKER_COUNT];
+	WorkItem item;
+
+	item.pFunction = pFunction;
+	item.pContext = pContext;
+
+	pthread_mutex_lock(&pWorker->mutex);
+	pWorker->items.push_back(item);
+	pthread_mutex_unlock(&pWorker->mutex);
+
+	pthread_mutex_lock(&sleepMutex);
+	iPending++;
+	pthread_cond_signal(&workCond);
+	pthread_mutex_unlock(&sleepMutex);
+}
+
+///Adds a task's wakeup jitter to what CoreLoadJob publishes
+void TaskScheduler::Watch(TaskJitter *pJitter)
+{
+	pthread_mutex_lock(&jitterMutex);
+	jitters.push_back(pJitter);
+	pthread_mutex_unlock(&jitterMutex);
+}
+
+void TaskScheduler::Unwatch(TaskJitter *pJitter)
+{
+	pthread_mutex_lock(&jitterMutex);
+
+	for(unsigned i = 0; i < jitters.size(); i++)
+	{
+		if(jitters[i] == pJitter)
+		{
+			jitters.erase(jitters.begin() + i);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&jitterMutex);
+}
+
+void TaskScheduler::DoWork(int iWorker)
+{
+	WorkItem item;
+
+	ConfigureTask(WORKER_TASKNAME);
+
+	while(true)
+	{
+		pthread_mutex_lock(&sleepMutex);
+
+		while(iPending.load() == 0)
+		{
+			pthread_cond_wait(&workCond, &sleepMutex);
+		}
+
+		pthread_mutex_unlock(&sleepMutex);
+
+		if(TakeWork(iWorker, &item))
+		{
+			item.pFunction(item.pContext);
+		}
+	}
+}
+
+///Takes the oldest job from our own queue, or steals the newest from someone else's
+bool TaskScheduler::TakeWork(int iWorker, WorkItem *pItem)
+{
+	SchedulerWorker *pVictim;
+	bool bFound = false;
+
+	pthread_mutex_lock(&workers[iWorker].mutex);
+
+	if(!workers[iWorker].items.empty())
+	{
+		*pItem = workers[iWorker].items.front();
+		workers[iWorker].items.pop_front();
+		bFound = true;
+	}
+
+	pthread_mutex_unlock(&workers[iWorker].mutex);
+
+	for(int i = 1; !bFound && (i < WORKER_COUNT); i++)
+	{
+		pVictim = &workers[(iWorker + i) % WORKER_COUNT];
+		pthread_mutex_lock(&pVictim->mutex);
+
+		if(!pVictim->items.empty())
+		{
+			*pItem = pVictim->items.back();
+			pVictim->items.pop_back();
+			bFound = true;
+			uSteals.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		pthread_mutex_unlock(&pVictim->mutex);
+	}
+
+	if(bFound)
+	{
+		iPending--;
+	}
+
+	return(bFound);
+}
+
+///Publishes how busy each core was since the last call, from /proc/stat
+void TaskScheduler::UpdateCoreLoad()
+{
+	char szLine[256];
+	char szKey[32];
+	int iCore;
+	unsigned long long ullUser, ullNice, ullSystem, ullIdle, ullIoWait, ullIrq, ullSoftIrq;
+	unsigned long long ullBusy, ullTotal;
+	FILE *pStat = fopen("/proc/stat", "r");
+
+	if(pStat == NULL)
+	{
+		return;
+	}
+
+	while(fgets(szLine, sizeof(szLine), pStat) != NULL)
+	{
+		// only the "cpuN ..." lines, not the "cpu ..." total
+
+		if((strncmp(szLine, "cpu", 3) != 0) || (szLine[3] < '0') || (szLine[3] > '9'))
+		{
+			continue;
+		}
+
+		if(sscanf(szLine, "cpu%d %llu %llu %llu %llu %llu %llu %llu", &iCore, &ullUser, &ullNice,
+				&ullSystem, &ullIdle, &ullIoWait, &ullIrq, &ullSoftIrq) != 8)
+		{
+			continue;
+		}
+
+		if((iCore < 0) || (iCore >= SCHEDULER_MAX_CORES))
+		{
+			continue;
+		}
+
+		ullBusy = ullUser + ullNice + ullSystem + ullIrq + ullSoftIrq;
+		ullTotal = ullBusy + ullIdle + ullIoWait;
+
+		if((ullLastTotal[iCore] != 0) && (ullTotal > ullLastTotal[iCore]))
+		{
+			sprintf(szKey, "Core %d %%", iCore);
+			SmartDashboard::PutNumber(szKey,
+					100.0 * (ullBusy - ullLastBusy[iCore]) / (double)(ullTotal - ullLastTotal[iCore]));
+		}
+
+		ullLastBusy[iCore] = ullBusy;
+		ullLastTotal[iCore] = ullTotal;
+	}
+
+	fclose(pStat);
+	SmartDashboard::PutNumber("Worker Steals", uSteals.load(std::memory_order_relaxed));
+}
+
+void TaskScheduler::PublishJitter()
+{
+	pthread_mutex_lock(&jitterMutex);
+
+	for(unsigned i = 0; i < jitters.size(); i++)
+	{
+		jitters[i]->Publish();
+	}
+
+	pthread_mutex_unlock(&jitterMutex);
+}
@@ -0,0 +1,90 @@
+/** \file
+ * Task placement and background worker pool declaration.
+ *
+ * Every task applies its row of TASK_CONFIGS in RobotParams.h when it starts, so the
+ * latency critical loops get a core of their own and a real time priority that lets
+ * them preempt anything else there.  Work that is not
+ * real time, like dashboard telemetry and reading the autonomous script, is handed
+ * to a small pool of workers on the background core.  Each worker has its own queue
+ * and steals from the others when its own runs dry, so one slow job (a file read on a
+ * busy flash) doesn't hold up everything queued behind it.
+ */
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <pthread.h>
+#include <atomic>
+#include <deque>
+#include <vector>
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotParams.h"
+
+///most cores we report utilization for
+const int SCHEDULER_MAX_CORES = 8;
+
+typedef void (*WorkFunction)(void *pContext);
+
+struct WorkItem {
+	WorkFunction pFunction;
+	void *pContext;
+};
+
+class TaskScheduler;
+class TaskJitter;
+
+///One worker task and the queue it owns
+struct SchedulerWorker {
+	TaskScheduler *pScheduler;
+	int iIndex;
+	Task *pTask;
+	pthread_mutex_t mutex;
+	std::deque<WorkItem> items;
+};
+
+class TaskScheduler
+{
+public:
+	static TaskScheduler *GetInstance();
+	static void ConfigureProcess();
+	static void ConfigureTask(const char *szTaskName);
+	static void *StartWorker(void *pWorker)
+	{
+		SchedulerWorker *pThis = (SchedulerWorker *)pWorker;
+
+		pThis->pScheduler->DoWork(pThis->iIndex);
+		return(NULL);
+	}
+	static void CoreLoadJob(void *pThis)
+	{
+		((TaskScheduler *)pThis)->UpdateCoreLoad();
+		((TaskScheduler *)pThis)->PublishJitter();
+	}
+
+	void Submit(WorkFunction pFunction, void *pContext);
+	void Watch(TaskJitter *pJitter);
+	void Unwatch(TaskJitter *pJitter);
+
+private:
+	SchedulerWorker workers[WORKER_COUNT];
+	pthread_mutex_t sleepMutex;
+	pthread_cond_t workCond;
+	std::atomic<int> iPending;
+	std::atomic<unsigned> uNextWorker;
+	std::atomic<unsigned> uSteals;
+	unsigned long long ullLastBusy[SCHEDULER_MAX_CORES];
+	unsigned long long ullLastTotal[SCHEDULER_MAX_CORES];
+	pthread_mutex_t jitterMutex;
+	std::vector<TaskJitter *> jitters;
+
+	TaskScheduler();
+	void DoWork(int iWorker);
+	bool TakeWork(int iWorker, WorkItem *pItem);
+	void UpdateCoreLoad();
+	void PublishJitter();
+};
+
+#endif //TASK_SCHEDULER_H
@@ -0,0 +1,130 @@
+/** \file
+ * Asynchronous dashboard telemetry implementation.
+ */
+
+#include "Telemetry.h"
+
+//Robot
+#include "RobotTime.h"
+#include "TaskJitter.h"
+#include "TaskScheduler.h"
+
+TelemetrySlot Telemetry::slots[TELEMETRY_SLOTS];
+std::atomic<int> Telemetry::iSlotCount(0);
+pthread_mutex_t Telemetry::internMutex = PTHREAD_MUTEX_INITIALIZER;
+Task *Telemetry::pTask = NULL;
+
+/**
+ * Returns the slot for a key, claiming a new one the first time the key is seen.  A
+ * key interned again keeps the period it was first given.  Starts the publisher the
+ * first time it is called.
+ */
+TelemetryKey Telemetry::Intern(const char *szKey, float fMinPeriod, bool bBoolean)
+{
+	TelemetryKey key = -1;
+	int iCount;
+
+	pthread_mutex_lock(&internMutex);
+	iCount = iSlotCount.load(std::memory_order_relaxed);
+
+	for(int i = 0; i < iCount; i++)
+	{
+		if(slots[i].key == szKey)
+		{
+			key = i;
+			break;
+		}
+	}
+
+	if((key < 0) && (iCount < TELEMETRY_SLOTS))
+	{
+		key = iCount;
+		slots[key].key = szKey;
+		slots[key].uMinPeriodNs = SecondsToNs(fMinPeriod);
+		slots[key].bBoolean = bBoolean;
+		slots[key].uBits.store(0);
+		slots[key].uVersion.store(1);			//so the first value goes out, whatever it is
+		slots[key].uPublishedVersion = 0;
+		slots[key].uLastPublishNs = 0;
+
+		// the publisher only looks at slots below the count
+
+		iSlotCount.store(iCount + 1, std::memory_order_release);
+	}
+
+	if(key < 0)
+	{
+		printf("Telemetry full, %s will not be published\n", szKey);
+	}
+
+	if(pTask == NULL)
+	{
+		pTask = new Task(TELEMETRY_TASKNAME, (FUNCPTR) &Telemetry::StartTask,
+				TELEMETRY_PRIORITY, TELEMETRY_STACKSIZE);
+		wpi_assert(pTask);
+		pTask->Start(0);
+	}
+
+	pthread_mutex_unlock(&internMutex);
+	return(key);
+}
+
+void Telemetry::DoWork()
+{
+	TaskJitter jitter(TELEMETRY_TASKNAME);
+	uint64_t uPeriod = SecondsToNs(TELEMETRY_PUBLISH_PERIOD);
+	uint64_t uNextFlush = GetMonotonicNs();
+
+	TaskScheduler::ConfigureTask(TELEMETRY_TASKNAME);
+
+	while(true)
+	{
+		Flush(GetMonotonicNs());
+
+		uNextFlush += uPeriod;
+
+		if(uNextFlush < GetMonotonicNs())
+		{
+			uNextFlush = GetMonotonicNs();
+		}
+
+		jitter.SleepUntil(uNextFlush);
+	}
+}
+
+///Sends every value that changed and whose key is due
+void Telemetry::Flush(uint64_t uNow)
+{
+	int iCount = iSlotCount.load(std::memory_order_acquire);
+	uint32_t uVersion;
+	uint64_t uBits;
+	double fValue;
+
+	for(int i = 0; i < iCount; i++)
+	{
+		TelemetrySlot *pSlot = &slots[i];
+
+		uVersion = pSlot->uVersion.load(std::memory_order_acquire);
+
+		if((uVersion == pSlot->uPublishedVersion) ||
+				(uNow - pSlot->uLastPublishNs < pSlot->uMinPeriodNs))
+		{
+			continue;
+		}
+
+		uBits = pSlot->uBits.load(std::memory_order_relaxed);
+		memcpy(&fValue, &uBits, sizeof(fValue));
+
+		if(pSlot->bBoolean)
+		{
+			SmartDashboard::PutBoolean(pSlot->key, fValue != 0.0);
+		}
+		else
+		{
+			SmartDashboard::PutNumber(pSlot->key, fValue);
+		}
+
+		pSlot->uPublishedVersion = uVersion;
+		pSlot->uLastPublishNs = uNow;
+	}
+}
@@ -0,0 +1,84 @@
+/** \file
+ * Asynchronous dashboard telemetry declaration.
+ *
+ * Anything that wants a value on the SmartDashboard interns its key once, outside the
+ * control loop, and gets back a TelemetryKey naming a preallocated slot.  Setting a
+ * value is then an atomic store into that slot: no strings, no locks and no network
+ * table work.  A low priority publisher task on the background core wakes every
+ * TELEMETRY_PUBLISH_PERIOD and sends each value that changed, no more often than the
+ * minimum period its key was interned with.
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+
+#include "WPILib.h"
+
+//Robot
+#include "RobotParams.h"
+
+///-1 if the key could not be interned, setting it does nothing
+typedef int TelemetryKey;
+
+struct TelemetrySlot {
+	std::string key;				//!< written before the slot is counted, never after
+	uint64_t uMinPeriodNs;
+	bool bBoolean;
+	std::atomic<uint64_t> uBits;	//!< the value's double, bit for bit
+	std::atomic<uint32_t> uVersion;	//!< bumped when the value changes
+	uint32_t uPublishedVersion;		//!< publisher only
+	uint64_t uLastPublishNs;		//!< publisher only
+};
+
+class Telemetry
+{
+public:
+	static TelemetryKey Intern(const char *szKey, float fMinPeriod = TELEMETRY_RATE_NORMAL,
+			bool bBoolean = false);
+
+	///Safe from any task, costs an atomic exchange
+	static void Set(TelemetryKey key, double fValue)
+	{
+		uint64_t uBits;
+
+		if(key < 0)
+		{
+			return;
+		}
+
+		memcpy(&uBits, &fValue, sizeof(uBits));
+
+		if(slots[key].uBits.exchange(uBits, std::memory_order_relaxed) != uBits)
+		{
+			slots[key].uVersion.fetch_add(1, std::memory_order_release);
+		}
+	}
+
+	static void SetBoolean(TelemetryKey key, bool bValue)
+	{
+		Set(key, bValue ? 1.0 : 0.0);
+	}
+
+	static void *StartTask(void *pUnused)
+	{
+		DoWork();
+		return(NULL);
+	}
+
+private:
+	static TelemetrySlot slots[TELEMETRY_SLOTS];
+	static std::atomic<int> iSlotCount;
+	static pthread_mutex_t internMutex;
+	static Task *pTask;
+
+	static void DoWork();
+	static void Flush(uint64_t uNow);
+};
+
+#endif //TELEMETRY_H
@@ -0,0 +1,258 @@
+/** \file
+ * Replays a logged match through the real robot code on a Linux host.
+ *
+ * The robot logs every driver station packet, its joysticks and every gyro SPI frame
+ * (RhsRobotBase::LogControlData, ADXRS453Z::Update).  This feeds them back through the
+ * WPILib stand-in in sim/ to RhsRobot, Drivetrain and Autonomous, built unchanged with
+ * ROBOT_SIM defined.  Every task runs on one host thread on a virtual clock, so a replay
+ * takes the same path every time and runs as fast as the host allows.  Built from the
+ * top of the tree:
+ *
+ *     g++ -std=gnu++11 -O2 -DROBOT_SIM -Isim -I. -Itools -o Replay sim/WPILib.cpp sim/Replay.cpp *.cpp -lpthread -lrt
+ *
+ * Run it in a scratch directory holding the RhsScript.txt the robot ran, since the code
+ * keeps its files there (datalog.bin, flight_*.bin, trace_*.csv):
+ *
+ *     ./Replay robot/datalog.bin [-o outputs.csv] [-t tail seconds]
+ *
+ * It prints how long the match ran and how long replaying it took, and a hash of every
+ * motor output with its virtual time.  Two replays of one log print the same hash; a
+ * change to the code that changes what the motors are told changes it.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Sim.h"
+#include "DataLogReader.h"
+#include "DataLog.h"
+
+static int RunRobot(intptr_t arg)
+{
+	SimCreateRobot()->StartCompetition();
+	return(0);
+}
+
+///Turns the log's inputs into packets and SPI frames, returns the time of the last one
+static uint64_t LoadInputs(const std::vector<DataLogRecord> &records)
+{
+	SimStick sticks[SIM_STICKS];
+	SimPacket packet;
+	uint8_t frame[SIM_SPI_BYTES];
+	uint64_t uLastNs = 0;
+	int iPackets = 0;
+	int iFrames = 0;
+
+	memset(sticks, 0, sizeof(sticks));
+
+	for(size_t r = 0; r < records.size(); r++)
+	{
+		const DataLogRecord &record = records[r];
+		SimStick *pStick = (record.uSource < SIM_STICKS) ? &sticks[record.uSource] : NULL;
+
+		switch(record.uType)
+		{
+		case DATALOG_TYPE_STICK:
+			if(pStick)
+			{
+				pStick->uButtons = (uint32_t)record.fValues[0];
+				pStick->iPov = (int)record.fValues[1];
+			}
+			break;
+
+		case DATALOG_TYPE_AXES_LOW:
+		case DATALOG_TYPE_AXES_HIGH:
+			if(pStick)
+			{
+				int iFirst = (record.uType == DATALOG_TYPE_AXES_LOW) ? 0 : DATALOG_VALUES;
+
+				memcpy(&pStick->fAxes[iFirst], record.fValues, sizeof(record.fValues));
+				pStick->iAxes = SIM_AXES;
+			}
+			break;
+
+		case DATALOG_TYPE_DRIVER_STATION:
+			// the joysticks logged just before belong to this packet
+
+			packet.uTimeNs = record.uTimeNs;
+			packet.iMode = (int)record.fValues[0];
+			memcpy(packet.sticks, sticks, sizeof(sticks));
+			SimAddPacket(packet);
+			uLastNs = record.uTimeNs;
+			iPackets++;
+			break;
+
+		case DATALOG_TYPE_SPI:
+			for(int i = 0; i < SIM_SPI_BYTES; i++)
+			{
+				frame[i] = (uint8_t)record.fValues[i];
+			}
+
+			SimAddSpiFrame(record.uSource, frame);
+
+			if(record.uTimeNs > uLastNs)
+			{
+				uLastNs = record.uTimeNs;
+			}
+
+			iFrames++;
+			break;
+
+		default:
+			break;
+		}
+	}
+
+	printf("Replaying %d driver station packets and %d SPI frames\n", iPackets, iFrames);
+	return(uLastNs);
+}
+
+///FNV-1a over every output, in order
+static uint64_t HashOutputs(const std::vector<SimOutput> &outputs)
+{
+	uint64_t uHash = 14695981039346656037ULL;
+
+	for(size_t i = 0; i < outputs.size(); i++)
+	{
+		const unsigned char *pBytes[3] = {
+			(const unsigned char *)&outputs[i].uTimeNs,
+			(const unsigned char *)&outputs[i].iDevice,
+			(const unsigned char *)&outputs[i].fValue
+		};
+		const size_t sizes[3] = { sizeof(outputs[i].uTimeNs), sizeof(outputs[i].iDevice), sizeof(outputs[i].fValue) };
+
+		for(int j = 0; j < 3; j++)
+		{
+			for(size_t k = 0; k < sizes[j]; k++)
+			{
+				uHash = (uHash ^ pBytes[j][k]) * 1099511628211ULL;
+			}
+		}
+	}
+
+	return(uHash);
+}
+
+static bool WriteOutputs(const char *szPath, uint64_t uStartNs, const std::vector<SimOutput> &outputs)
+{
+	FILE *pFile = fopen(szPath, "w");
+
+	if(pFile == NULL)
+	{
+		fprintf(stderr, "cannot write %s\n", szPath);
+		return(false);
+	}
+
+	fprintf(pFile, "time_s,device,value\n");
+
+	for(size_t i = 0; i < outputs.size(); i++)
+	{
+		fprintf(pFile, "%.6f,%d,%.9g\n", (int64_t)(outputs[i].uTimeNs - uStartNs) / 1e9,
+				outputs[i].iDevice, outputs[i].fValue);
+	}
+
+	fclose(pFile);
+	return(true);
+}
+
+///The robot code writes its own datalog.bin where we run, it must not replace the one we read
+static bool IsOwnLog(const char *szPath)
+{
+	char szInput[PATH_MAX];
+	char szOwn[PATH_MAX];
+	const char *szOwnNames[] = { "datalog.bin", "datalog.bin.prev" };
+
+	if(realpath(szPath, szInput) == NULL)
+	{
+		return(false);
+	}
+
+	for(int i = 0; i < 2; i++)
+	{
+		if((realpath(szOwnNames[i], szOwn) != NULL) && (strcmp(szInput, szOwn) == 0))
+		{
+			return(true);
+		}
+	}
+
+	return(false);
+}
+
+int main(int argc, char **argv)
+{
+	DataLogHeader header;
+	std::vector<DataLogRecord> records;
+	const char *szOutputs = NULL;
+	double fTail = 1.0;
+	uint64_t uEndNs;
+	struct timespec wallStart, wallEnd;
+	double fMatch, fWall;
+
+	if(argc < 2)
+	{
+		fprintf(stderr, "usage: %s <datalog.bin> [-o outputs.csv] [-t tail seconds]\n", argv[0]);
+		return(2);
+	}
+
+	for(int i = 2; i + 1 < argc; i += 2)
+	{
+		if(strcmp(argv[i], "-o") == 0)
+		{
+			szOutputs = argv[i + 1];
+		}
+		else if(strcmp(argv[i], "-t") == 0)
+		{
+			fTail = atof(argv[i + 1]);
+		}
+	}
+
+	if(IsOwnLog(argv[1]))
+	{
+		fprintf(stderr, "%s would be overwritten by the replay's own log, copy it somewhere else\n", argv[1]);
+		return(2);
+	}
+
+	if(!ReadDataLog(argv[1], &header, &records))
+	{
+		return(1);
+	}
+
+	// the virtual clock starts where the robot's did, when it opened the log
+
+	SimReset(header.uStartTimeNs);
+	uEndNs = LoadInputs(records) + (uint64_t)(fTail * 1e9);
+	records.clear();
+
+	Task robotTask("tRobotMain", (FUNCPTR) &RunRobot);
+
+	clock_gettime(CLOCK_MONOTONIC, &wallStart);
+	robotTask.Start();
+	SimRunUntil(uEndNs);
+	clock_gettime(CLOCK_MONOTONIC, &wallEnd);
+
+	// the last moments are still in the log's memory ring, the robot would drain them soon
+
+	DataLog::Drain();
+
+	fMatch = (uEndNs - header.uStartTimeNs) / 1e9;
+	fWall = (wallEnd.tv_sec - wallStart.tv_sec) + (wallEnd.tv_nsec - wallStart.tv_nsec) / 1e9;
+
+	printf("Replayed %.3f s in %.3f s (%.1fx real time)\n", fMatch, fWall, (fWall > 0.0) ? fMatch / fWall : 0.0);
+	printf("%zu motor outputs, hash %016llx\n", SimGetOutputs().size(),
+			(unsigned long long)HashOutputs(SimGetOutputs()));
+
+	if(szOutputs && !WriteOutputs(szOutputs, header.uStartTimeNs, SimGetOutputs()))
+	{
+		return(1);
+	}
+
+	// the robot's tasks never return, leave them where they are
+
+	fflush(stdout);
+	_exit(0);
+}
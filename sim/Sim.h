@@ -0,0 +1,54 @@
+/** \file
+ * Replay harness behind the WPILib stand-in.
+ *
+ * sim/Replay.cpp loads a data log into driver station packets and SPI frames, then runs
+ * the robot on the virtual clock.  Time only moves when every task is asleep: the clock
+ * jumps to the earliest wakeup and that task runs until it sleeps again, ties going to
+ * the task started first.  Nothing depends on the host's timing or thread scheduling,
+ * so the same log always drives the code through the same steps.
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stdint.h>
+#include <vector>
+
+#include "WPILib.h"
+
+const int SIM_STICKS = 6;
+const int SIM_AXES = 8;
+const int SIM_SPI_PORTS = SPI::kMXP + 1;
+const int SIM_SPI_BYTES = 4;
+
+struct SimStick {
+	uint32_t uButtons;
+	int iPov;
+	int iAxes;
+	float fAxes[SIM_AXES];
+};
+
+///One driver station packet, as RhsRobotBase::LogControlData logged it
+struct SimPacket {
+	uint64_t uTimeNs;
+	int iMode;						//!< DATALOG_MODE bits
+	SimStick sticks[SIM_STICKS];
+};
+
+///One motor controller Set() call
+struct SimOutput {
+	uint64_t uTimeNs;
+	int iDevice;
+	float fValue;
+};
+
+void SimReset(uint64_t uStartNs);
+void SimAddPacket(const SimPacket &packet);
+void SimAddSpiFrame(int iPort, const uint8_t *pData);
+void SimRunUntil(uint64_t uEndNs);
+const std::vector<SimOutput> &SimGetOutputs();
+
+///Defined by START_ROBOT_CLASS in the robot code
+RobotBase *SimCreateRobot();
+
+#endif //SIM_H
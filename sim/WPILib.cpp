@@ -0,0 +1,490 @@
+/** \file
+ * WPILib stand-in and replay harness implementation.
+ */
+
+#include "Sim.h"
+#include <string.h>
+#include <stdlib.h>
+#include <ucontext.h>
+#include <map>
+
+//Robot
+#include "DataLogFormat.h"
+
+///a coroutine's stack, WPILib's default is too small for printf on a host
+const uint32_t SIM_MIN_STACK = 512 * 1024;
+
+struct SimTask {
+	std::string name;
+	FUNCPTR pFunction;
+	intptr_t arg;
+	ucontext_t context;
+	std::vector<char> stack;
+	uint64_t uWakeNs;
+	bool bStarted;
+	bool bSuspended;
+	bool bFinished;
+};
+
+static uint64_t uNowNs = 0;
+static std::vector<SimTask *> tasks;			//in the order they were created
+static SimTask *pCurrent = NULL;
+static ucontext_t harnessContext;
+
+static std::vector<SimPacket> packets;
+static size_t uNextPacket = 0;
+static SimPacket currentPacket;
+
+static std::vector<std::vector<uint8_t> > spiFrames[SIM_SPI_PORTS];
+static size_t uNextSpiFrame[SIM_SPI_PORTS];
+
+static std::vector<SimOutput> outputs;
+
+static std::map<std::string, double> dashboardNumbers;
+static std::map<std::string, std::string> dashboardStrings;
+static std::map<std::string, bool> dashboardBooleans;
+
+static RobotBase *pRobot = NULL;
+
+uint64_t SimGetTimeNs()
+{
+	return(uNowNs);
+}
+
+///Gives the host thread back to the harness until the virtual clock reaches uWakeNs
+void SimSleepUntil(uint64_t uWakeNs)
+{
+	if(pCurrent == NULL)
+	{
+		// not on a task, nobody else can run meanwhile
+
+		if(uWakeNs > uNowNs)
+		{
+			uNowNs = uWakeNs;
+		}
+
+		return;
+	}
+
+	pCurrent->uWakeNs = uWakeNs;
+	swapcontext(&pCurrent->context, &harnessContext);
+}
+
+static void SimTaskEntry()
+{
+	SimTask *pTask = pCurrent;
+
+	((int (*)(intptr_t))pTask->pFunction)(pTask->arg);
+	pTask->bFinished = true;
+}
+
+void SimReset(uint64_t uStartNs)
+{
+	uNowNs = uStartNs;
+	packets.clear();
+	uNextPacket = 0;
+	memset(&currentPacket, 0, sizeof(currentPacket));
+	outputs.clear();
+
+	for(int i = 0; i < SIM_SPI_PORTS; i++)
+	{
+		spiFrames[i].clear();
+		uNextSpiFrame[i] = 0;
+	}
+}
+
+void SimAddPacket(const SimPacket &packet)
+{
+	packets.push_back(packet);
+}
+
+void SimAddSpiFrame(int iPort, const uint8_t *pData)
+{
+	if((iPort >= 0) && (iPort < SIM_SPI_PORTS))
+	{
+		spiFrames[iPort].push_back(std::vector<uint8_t>(pData, pData + SIM_SPI_BYTES));
+	}
+}
+
+///Runs whichever task wakes first, over and over, until the next wakeup is past uEndNs
+void SimRunUntil(uint64_t uEndNs)
+{
+	SimTask *pNext;
+
+	while(true)
+	{
+		pNext = NULL;
+
+		for(unsigned i = 0; i < tasks.size(); i++)
+		{
+			if(tasks[i]->bStarted && !tasks[i]->bSuspended && !tasks[i]->bFinished &&
+					((pNext == NULL) || (tasks[i]->uWakeNs < pNext->uWakeNs)))
+			{
+				pNext = tasks[i];
+			}
+		}
+
+		if((pNext == NULL) || (pNext->uWakeNs > uEndNs))
+		{
+			break;
+		}
+
+		if(pNext->uWakeNs > uNowNs)
+		{
+			uNowNs = pNext->uWakeNs;
+		}
+
+		pCurrent = pNext;
+		swapcontext(&harnessContext, &pNext->context);
+		pCurrent = NULL;
+	}
+
+	if(uEndNs > uNowNs)
+	{
+		uNowNs = uEndNs;
+	}
+}
+
+const std::vector<SimOutput> &SimGetOutputs()
+{
+	return(outputs);
+}
+
+Task::Task(const char *szName, FUNCPTR pFunction, int32_t iPriority, uint32_t uStackSize)
+{
+	pSimTask = new SimTask;
+	pSimTask->name = szName;
+	pSimTask->pFunction = pFunction;
+	pSimTask->arg = 0;
+	pSimTask->stack.resize((uStackSize > SIM_MIN_STACK) ? uStackSize : SIM_MIN_STACK);
+	pSimTask->uWakeNs = 0;
+	pSimTask->bStarted = false;
+	pSimTask->bSuspended = false;
+	pSimTask->bFinished = false;
+	tasks.push_back(pSimTask);
+}
+
+///The coroutine stays with the harness, a deleted Task just stops being scheduled
+Task::~Task()
+{
+	pSimTask->bFinished = true;
+}
+
+bool Task::Start(intptr_t arg0)
+{
+	if(pSimTask->bStarted)
+	{
+		return(false);
+	}
+
+	pSimTask->arg = arg0;
+	getcontext(&pSimTask->context);
+	pSimTask->context.uc_stack.ss_sp = pSimTask->stack.data();
+	pSimTask->context.uc_stack.ss_size = pSimTask->stack.size();
+	pSimTask->context.uc_link = &harnessContext;
+	makecontext(&pSimTask->context, &SimTaskEntry, 0);
+	pSimTask->uWakeNs = uNowNs;
+	pSimTask->bStarted = true;
+	return(true);
+}
+
+bool Task::Suspend()
+{
+	pSimTask->bSuspended = true;
+
+	if(pCurrent == pSimTask)
+	{
+		SimSleepUntil(uNowNs);
+	}
+
+	return(true);
+}
+
+bool Task::Resume()
+{
+	pSimTask->bSuspended = false;
+
+	if(pSimTask->uWakeNs < uNowNs)
+	{
+		pSimTask->uWakeNs = uNowNs;
+	}
+
+	return(true);
+}
+
+void Wait(double fSeconds)
+{
+	SimSleepUntil(uNowNs + (uint64_t)(fSeconds * 1e9));
+}
+
+Timer::Timer()
+{
+	uStartNs = uNowNs;
+	uAccumulatedNs = 0;
+	bRunning = false;
+}
+
+double Timer::Get()
+{
+	uint64_t uElapsed = uAccumulatedNs;
+
+	if(bRunning)
+	{
+		uElapsed += uNowNs - uStartNs;
+	}
+
+	return(uElapsed / 1e9);
+}
+
+void Timer::Reset()
+{
+	uAccumulatedNs = 0;
+	uStartNs = uNowNs;
+}
+
+void Timer::Start()
+{
+	if(!bRunning)
+	{
+		uStartNs = uNowNs;
+		bRunning = true;
+	}
+}
+
+void Timer::Stop()
+{
+	if(bRunning)
+	{
+		uAccumulatedNs += uNowNs - uStartNs;
+		bRunning = false;
+	}
+}
+
+void SmartDashboard::init()
+{
+}
+
+void SmartDashboard::PutNumber(std::string key, double fValue)
+{
+	dashboardNumbers[key] = fValue;
+}
+
+double SmartDashboard::GetNumber(std::string key, double fDefault)
+{
+	std::map<std::string, double>::iterator entry = dashboardNumbers.find(key);
+
+	return((entry != dashboardNumbers.end()) ? entry->second : fDefault);
+}
+
+void SmartDashboard::PutString(std::string key, std::string value)
+{
+	dashboardStrings[key] = value;
+}
+
+std::string SmartDashboard::GetString(std::string key, std::string defaultValue)
+{
+	std::map<std::string, std::string>::iterator entry = dashboardStrings.find(key);
+
+	return((entry != dashboardStrings.end()) ? entry->second : defaultValue);
+}
+
+void SmartDashboard::PutBoolean(std::string key, bool bValue)
+{
+	dashboardBooleans[key] = bValue;
+}
+
+bool SmartDashboard::GetBoolean(std::string key, bool bDefault)
+{
+	std::map<std::string, bool>::iterator entry = dashboardBooleans.find(key);
+
+	return((entry != dashboardBooleans.end()) ? entry->second : bDefault);
+}
+
+DriverStation *DriverStation::GetInstance()
+{
+	static DriverStation driverStation;
+
+	return(&driverStation);
+}
+
+///True once for each logged packet whose time has come, packets that arrived together count once
+bool DriverStation::IsNewControlData()
+{
+	bool bNew = false;
+
+	while((uNextPacket < packets.size()) && (packets[uNextPacket].uTimeNs <= uNowNs))
+	{
+		currentPacket = packets[uNextPacket++];
+		bNew = true;
+	}
+
+	return(bNew);
+}
+
+bool DriverStation::IsEnabled()
+{
+	return((currentPacket.iMode & DATALOG_MODE_ENABLED) != 0);
+}
+
+bool DriverStation::IsDisabled()
+{
+	return(!IsEnabled());
+}
+
+bool DriverStation::IsAutonomous()
+{
+	return((currentPacket.iMode & DATALOG_MODE_AUTONOMOUS) != 0);
+}
+
+bool DriverStation::IsOperatorControl()
+{
+	return(!IsAutonomous() && !IsTest());
+}
+
+bool DriverStation::IsTest()
+{
+	return((currentPacket.iMode & DATALOG_MODE_TEST) != 0);
+}
+
+float DriverStation::GetStickAxis(uint32_t uStick, uint32_t uAxis)
+{
+	if((uStick >= (uint32_t)SIM_STICKS) || (uAxis >= (uint32_t)SIM_AXES))
+	{
+		return(0.0);
+	}
+
+	return(currentPacket.sticks[uStick].fAxes[uAxis]);
+}
+
+int DriverStation::GetStickAxisCount(uint32_t uStick)
+{
+	return((uStick < (uint32_t)SIM_STICKS) ? currentPacket.sticks[uStick].iAxes : 0);
+}
+
+uint32_t DriverStation::GetStickButtons(uint32_t uStick)
+{
+	return((uStick < (uint32_t)SIM_STICKS) ? currentPacket.sticks[uStick].uButtons : 0);
+}
+
+int DriverStation::GetStickPOV(uint32_t uStick, uint32_t uPov)
+{
+	return(((uStick < (uint32_t)SIM_STICKS) && (uPov == 0)) ? currentPacket.sticks[uStick].iPov : -1);
+}
+
+int DriverStation::GetStickPOVCount(uint32_t uStick)
+{
+	return(1);
+}
+
+Joystick::Joystick(uint32_t uPort)
+{
+	this->uPort = uPort;
+}
+
+float Joystick::GetRawAxis(uint32_t uAxis)
+{
+	return(DriverStation::GetInstance()->GetStickAxis(uPort, uAxis));
+}
+
+///Buttons count from 1, like WPILib's
+bool Joystick::GetRawButton(uint32_t uButton)
+{
+	return((uButton > 0) && ((DriverStation::GetInstance()->GetStickButtons(uPort) >> (uButton - 1)) & 1));
+}
+
+int Joystick::GetPOV(uint32_t uPov)
+{
+	return(DriverStation::GetInstance()->GetStickPOV(uPort, uPov));
+}
+
+SPI::SPI(Port port)
+{
+	this->port = port;
+}
+
+/**
+ * Answers with the port's logged frames in the order they were read on the robot, and
+ * with the last one again once they run out.  The gyro reads on a fixed period, so the
+ * replay reads the same frames at close to the same times.
+ */
+int32_t SPI::Transaction(uint8_t *pDataToSend, uint8_t *pDataReceived, uint8_t uSize)
+{
+	std::vector<std::vector<uint8_t> > &frames = spiFrames[port];
+	size_t uFrame = uNextSpiFrame[port];
+
+	memset(pDataReceived, 0, uSize);
+
+	if(frames.empty())
+	{
+		return(uSize);
+	}
+
+	if(uFrame < frames.size())
+	{
+		uNextSpiFrame[port]++;
+	}
+	else
+	{
+		uFrame = frames.size() - 1;
+	}
+
+	memcpy(pDataReceived, frames[uFrame].data(), (uSize < SIM_SPI_BYTES) ? uSize : SIM_SPI_BYTES);
+	return(uSize);
+}
+
+CANTalon::CANTalon(int iDeviceNumber)
+{
+	this->iDeviceNumber = iDeviceNumber;
+	fValue = 0.0;
+}
+
+void CANTalon::Set(float fValue, uint8_t uSyncGroup)
+{
+	SimOutput output;
+
+	this->fValue = fValue;
+	output.uTimeNs = uNowNs;
+	output.iDevice = iDeviceNumber;
+	output.fValue = fValue;
+	outputs.push_back(output);
+}
+
+float CANTalon::Get()
+{
+	return(fValue);
+}
+
+RobotBase::RobotBase()
+{
+	pRobot = this;
+}
+
+RobotBase &RobotBase::getInstance()
+{
+	return(*pRobot);
+}
+
+bool RobotBase::IsEnabled()
+{
+	return(DriverStation::GetInstance()->IsEnabled());
+}
+
+bool RobotBase::IsDisabled()
+{
+	return(DriverStation::GetInstance()->IsDisabled());
+}
+
+bool RobotBase::IsAutonomous()
+{
+	return(DriverStation::GetInstance()->IsAutonomous());
+}
+
+bool RobotBase::IsOperatorControl()
+{
+	return(DriverStation::GetInstance()->IsOperatorControl());
+}
+
+bool RobotBase::IsTest()
+{
+	return(DriverStation::GetInstance()->IsTest());
+}
@@ -0,0 +1,203 @@
+/** \file
+ * WPILib stand-in for replaying a match on a Linux host.
+ *
+ * Declares just the part of WPILib the robot code uses.  Nothing here touches hardware:
+ * every Task is a coroutine on one host thread and time is the replay's virtual clock,
+ * so tasks interleave the same way on every run.  The driver station, joysticks and SPI
+ * read back what the robot logged, and motor controllers record what they are told.
+ * See sim/Replay.cpp.
+ */
+
+#ifndef SIM_WPILIB_H
+#define SIM_WPILIB_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+typedef int (*FUNCPTR)(...);
+
+///Reports like WPILib does and carries on
+#define wpi_assert(condition) \
+	((condition) ? (void)0 : (void)fprintf(stderr, "assertion \"%s\" failed at %s:%d\n", #condition, __FILE__, __LINE__))
+
+struct SimTask;
+
+class Task
+{
+public:
+	static const int32_t kDefaultPriority = 101;
+
+	Task(const char *szName, FUNCPTR pFunction, int32_t iPriority = kDefaultPriority,
+			uint32_t uStackSize = 20000);
+	~Task();
+
+	bool Start(intptr_t arg0 = 0);
+	bool Suspend();
+	bool Resume();
+
+private:
+	SimTask *pSimTask;
+};
+
+///Sleeps the calling task on the virtual clock
+void Wait(double fSeconds);
+
+class Timer
+{
+public:
+	Timer();
+
+	double Get();
+	void Reset();
+	void Start();
+	void Stop();
+
+private:
+	uint64_t uStartNs;
+	uint64_t uAccumulatedNs;
+	bool bRunning;
+};
+
+class SmartDashboard
+{
+public:
+	static void init();
+	static void PutNumber(std::string key, double fValue);
+	static double GetNumber(std::string key, double fDefault);
+	static void PutString(std::string key, std::string value);
+	static std::string GetString(std::string key, std::string defaultValue);
+	static void PutBoolean(std::string key, bool bValue);
+	static bool GetBoolean(std::string key, bool bDefault);
+};
+
+class DriverStation
+{
+public:
+	static DriverStation *GetInstance();
+
+	bool IsNewControlData();
+	bool IsEnabled();
+	bool IsDisabled();
+	bool IsAutonomous();
+	bool IsOperatorControl();
+	bool IsTest();
+	float GetStickAxis(uint32_t uStick, uint32_t uAxis);
+	int GetStickAxisCount(uint32_t uStick);
+	uint32_t GetStickButtons(uint32_t uStick);
+	int GetStickPOV(uint32_t uStick, uint32_t uPov);
+	int GetStickPOVCount(uint32_t uStick);
+};
+
+class Joystick
+{
+public:
+	explicit Joystick(uint32_t uPort);
+
+	float GetRawAxis(uint32_t uAxis);
+	bool GetRawButton(uint32_t uButton);
+	int GetPOV(uint32_t uPov = 0);
+
+private:
+	uint32_t uPort;
+};
+
+class SPI
+{
+public:
+	enum Port { kOnboardCS0, kOnboardCS1, kOnboardCS2, kOnboardCS3, kMXP };
+
+	explicit SPI(Port port);
+
+	void SetClockRate(double fHz) {}
+	void SetMSBFirst() {}
+	void SetLSBFirst() {}
+	void SetClockActiveLow() {}
+	void SetClockActiveHigh() {}
+	void SetChipSelectActiveHigh() {}
+	void SetChipSelectActiveLow() {}
+	int32_t Transaction(uint8_t *pDataToSend, uint8_t *pDataReceived, uint8_t uSize);
+
+private:
+	Port port;
+};
+
+class CANSpeedController
+{
+public:
+	enum ControlMode { kPercentVbus, kCurrent, kSpeed, kPosition, kVoltage, kFollower };
+};
+
+class CANTalon : public CANSpeedController
+{
+public:
+	explicit CANTalon(int iDeviceNumber);
+
+	void Set(float fValue, uint8_t uSyncGroup = 0);
+	float Get();
+	void SetControlMode(ControlMode mode) {}
+	void SetVoltageRampRate(double fRampRate) {}
+	bool IsAlive() { return(true); }
+
+private:
+	int iDeviceNumber;
+	float fValue;
+};
+
+///Not logged by the robot, reads as not moving
+class Encoder
+{
+public:
+	enum EncodingType { k1X, k2X, k4X };
+
+	Encoder(uint32_t uChannelA, uint32_t uChannelB, bool bReverse = false, EncodingType type = k4X) {}
+
+	int32_t Get() { return(0); }
+	double GetDistance() { return(0.0); }
+	void Reset() {}
+	void SetDistancePerPulse(double fDistance) {}
+};
+
+///Not logged by the robot, reads as open
+class DigitalInput
+{
+public:
+	explicit DigitalInput(uint32_t uChannel) {}
+
+	bool Get() { return(false); }
+};
+
+class BuiltInAccelerometer
+{
+public:
+	double GetX() { return(0.0); }
+	double GetY() { return(0.0); }
+	double GetZ() { return(0.0); }
+};
+
+class RobotBase
+{
+public:
+	static RobotBase &getInstance();
+
+	bool IsEnabled();
+	bool IsDisabled();
+	bool IsAutonomous();
+	bool IsOperatorControl();
+	bool IsTest();
+	virtual void StartCompetition() = 0;
+
+protected:
+	RobotBase();
+	virtual ~RobotBase() {}
+};
+
+///The replay builds the robot itself instead of main() doing it
+#define START_ROBOT_CLASS(_ClassName_) \
+	RobotBase *SimCreateRobot() \
+	{ \
+		return(new _ClassName_()); \
+	}
+
+#endif //SIM_WPILIB_H
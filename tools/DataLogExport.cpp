@@ -0,0 +1,185 @@
+/** \file
+ * Converts a robot data log to CSV or to one binary file per column.
+ *
+ * Runs on a laptop, not the robot:
+ *
+ *     g++ -std=c++11 -O2 -I.. -o DataLogExport DataLogExport.cpp
+ *     ./DataLogExport datalog.bin csv out/
+ *     ./DataLogExport datalog.bin columns out/
+ *
+ * csv writes out/<type>.csv for each record type.  columns writes out/<type>/ holding
+ * time_s.f64, source.u16 and a .f32 file for each value, raw little endian arrays of
+ * equal length that numpy.fromfile or any columnar tool loads directly, plus a
+ * schema.txt naming them.  Times are seconds since the log was opened.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <string>
+#include <vector>
+
+#include "DataLogReader.h"
+
+static int CountColumns(int iType)
+{
+	int iColumns = 0;
+
+	while((iColumns < DATALOG_VALUES) && (DATALOG_COLUMNS[iType][iColumns][0] != '\0'))
+	{
+		iColumns++;
+	}
+
+	return(iColumns);
+}
+
+static double GetSeconds(const DataLogHeader &header, const DataLogRecord &record)
+{
+	return((int64_t)(record.uTimeNs - header.uStartTimeNs) / 1e9);
+}
+
+static bool WriteCsv(const DataLogHeader &header, const std::vector<DataLogRecord> &records,
+		const std::string &directory)
+{
+	for(int iType = 0; iType < DATALOG_TYPE_LAST; iType++)
+	{
+		std::string path = directory + "/" + DATALOG_TYPE_NAMES[iType] + ".csv";
+		FILE *pFile = fopen(path.c_str(), "w");
+		int iColumns = CountColumns(iType);
+
+		if(pFile == NULL)
+		{
+			fprintf(stderr, "cannot write %s\n", path.c_str());
+			return(false);
+		}
+
+		fprintf(pFile, "time_s,source");
+
+		for(int i = 0; i < iColumns; i++)
+		{
+			fprintf(pFile, ",%s", DATALOG_COLUMNS[iType][i]);
+		}
+
+		fprintf(pFile, "\n");
+
+		for(size_t r = 0; r < records.size(); r++)
+		{
+			if(records[r].uType != iType)
+			{
+				continue;
+			}
+
+			fprintf(pFile, "%.6f,%u", GetSeconds(header, records[r]), records[r].uSource);
+
+			for(int i = 0; i < iColumns; i++)
+			{
+				fprintf(pFile, ",%.9g", records[r].fValues[i]);
+			}
+
+			fprintf(pFile, "\n");
+		}
+
+		fclose(pFile);
+	}
+
+	return(true);
+}
+
+static bool WriteColumns(const DataLogHeader &header, const std::vector<DataLogRecord> &records,
+		const std::string &directory)
+{
+	for(int iType = 0; iType < DATALOG_TYPE_LAST; iType++)
+	{
+		std::string typeDirectory = directory + "/" + DATALOG_TYPE_NAMES[iType];
+		int iColumns = CountColumns(iType);
+		std::vector<double> times;
+		std::vector<uint16_t> sources;
+		std::vector<float> values[DATALOG_VALUES];
+		FILE *pFile;
+
+		mkdir(typeDirectory.c_str(), 0755);
+
+		for(size_t r = 0; r < records.size(); r++)
+		{
+			if(records[r].uType != iType)
+			{
+				continue;
+			}
+
+			times.push_back(GetSeconds(header, records[r]));
+			sources.push_back(records[r].uSource);
+
+			for(int i = 0; i < iColumns; i++)
+			{
+				values[i].push_back(records[r].fValues[i]);
+			}
+		}
+
+		pFile = fopen((typeDirectory + "/time_s.f64").c_str(), "wb");
+
+		if(pFile == NULL)
+		{
+			fprintf(stderr, "cannot write to %s\n", typeDirectory.c_str());
+			return(false);
+		}
+
+		fwrite(times.data(), sizeof(double), times.size(), pFile);
+		fclose(pFile);
+
+		pFile = fopen((typeDirectory + "/source.u16").c_str(), "wb");
+		fwrite(sources.data(), sizeof(uint16_t), sources.size(), pFile);
+		fclose(pFile);
+
+		for(int i = 0; i < iColumns; i++)
+		{
+			pFile = fopen((typeDirectory + "/" + DATALOG_COLUMNS[iType][i] + ".f32").c_str(), "wb");
+			fwrite(values[i].data(), sizeof(float), values[i].size(), pFile);
+			fclose(pFile);
+		}
+
+		pFile = fopen((typeDirectory + "/schema.txt").c_str(), "w");
+		fprintf(pFile, "rows %zu\ntime_s.f64 float64\nsource.u16 uint16\n", times.size());
+
+		for(int i = 0; i < iColumns; i++)
+		{
+			fprintf(pFile, "%s.f32 float32\n", DATALOG_COLUMNS[iType][i]);
+		}
+
+		fclose(pFile);
+	}
+
+	return(true);
+}
+
+int main(int argc, char **argv)
+{
+	DataLogHeader header;
+	std::vector<DataLogRecord> records;
+	bool bWritten = false;
+
+	if((argc != 4) || ((strcmp(argv[2], "csv") != 0) && (strcmp(argv[2], "columns") != 0)))
+	{
+		fprintf(stderr, "usage: %s <datalog.bin> csv|columns <output directory>\n", argv[0]);
+		return(2);
+	}
+
+	if(!ReadDataLog(argv[1], &header, &records))
+	{
+		return(1);
+	}
+
+	mkdir(argv[3], 0755);
+
+	if(strcmp(argv[2], "csv") == 0)
+	{
+		bWritten = WriteCsv(header, records, argv[3]);
+	}
+	else
+	{
+		bWritten = WriteColumns(header, records, argv[3]);
+	}
+
+	printf("%zu of %llu records exported\n", records.size(), (unsigned long long)header.uNextRecord);
+	return(bWritten ? 0 : 1);
+}
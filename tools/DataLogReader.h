@@ -0,0 +1,69 @@
+/** \file
+ * Data log reader shared by the laptop tools.
+ *
+ * Header only, so each tool builds from a single g++ line.  Like DataLogFormat.h it must
+ * not include WPILib or anything else robot specific.
+ */
+
+#ifndef DATA_LOG_READER_H
+#define DATA_LOG_READER_H
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+
+#include "DataLogFormat.h"
+
+///Every complete record in the log, oldest first
+inline bool ReadDataLog(const char *szPath, DataLogHeader *pHeader, std::vector<DataLogRecord> *pRecords)
+{
+	FILE *pFile = fopen(szPath, "rb");
+	std::vector<DataLogRecord> ring;
+	uint64_t uFirst;
+
+	if(pFile == NULL)
+	{
+		fprintf(stderr, "cannot open %s\n", szPath);
+		return(false);
+	}
+
+	if((fread(pHeader, sizeof(*pHeader), 1, pFile) != 1) ||
+			(memcmp(pHeader->szMagic, DATALOG_MAGIC, sizeof(DATALOG_MAGIC)) != 0) ||
+			(pHeader->uVersion != DATALOG_VERSION) ||
+			(pHeader->uRecordSize != sizeof(DataLogRecord)))
+	{
+		fprintf(stderr, "%s is not a version %u data log\n", szPath, DATALOG_VERSION);
+		fclose(pFile);
+		return(false);
+	}
+
+	ring.resize(pHeader->uCapacity);
+
+	if(fread(ring.data(), sizeof(DataLogRecord), ring.size(), pFile) != ring.size())
+	{
+		fprintf(stderr, "%s is truncated\n", szPath);
+		fclose(pFile);
+		return(false);
+	}
+
+	fclose(pFile);
+
+	// only the last uCapacity records survive, and any of those may be torn
+
+	uFirst = (pHeader->uNextRecord > pHeader->uCapacity) ? (pHeader->uNextRecord - pHeader->uCapacity) : 0;
+
+	for(uint64_t uRecord = uFirst; uRecord < pHeader->uNextRecord; uRecord++)
+	{
+		const DataLogRecord &record = ring[uRecord % pHeader->uCapacity];
+
+		if((record.uSequence == (uint32_t)(uRecord + 1)) && (record.uType < DATALOG_TYPE_LAST))
+		{
+			pRecords->push_back(record);
+		}
+	}
+
+	return(true);
+}
+
+#endif //DATA_LOG_READER_H
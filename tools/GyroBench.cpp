@@ -0,0 +1,278 @@
+/** \file
+ * Compares the gyro integration schemes on a laptop.
+ *
+ *     g++ -std=c++11 -O2 -I.. -o GyroBench GyroBench.cpp ../GyroIntegrator.cpp
+ *     ./GyroBench
+ *     ./GyroBench datalog.bin [calibration seconds]
+ *
+ * With no log it integrates a synthetic match, a sum of sines whose angle is known
+ * exactly, sampled the way the robot used to (every 10 ms) and does now (every 1 ms),
+ * evenly and unevenly, exactly and quantized to the ADXRS453Z's 1/80 deg/s.  Each scheme's error
+ * at the end is reported as drift in degrees per minute, next to the float, Timer
+ * based rectangle rule the gyro used before.
+ *
+ * With a log it integrates the SPI frames ADXRS453Z::Update() logged, removing the mean
+ * rate of the first seconds as calibration does.  There is no true angle to compare
+ * with: on a robot that sat still every scheme should read zero, on one that moved the
+ * spread between them is the integration error.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <math.h>
+#include <vector>
+
+#include "DataLogReader.h"
+#include "GyroIntegrator.h"
+
+const double BENCH_SECONDS = 300.0;
+const double BENCH_LSB_PER_DEG = 80.0;	//ADXRS453Z counts per deg/s
+
+struct BenchSine {
+	double fAmplitude;	//deg/s
+	double fHz;
+	double fPhase;
+};
+
+//Turning back and forth slowly, correcting quickly and some vibration.  No whole number
+//of cycles fits BENCH_SECONDS, which would let a scheme's errors cancel by the end.
+const BenchSine BENCH_SINES[] = {
+	{ 90.0, 0.2317, 0.3 },
+	{ 40.0, 1.3091, 1.1 },
+	{ 10.0, 7.0713, 2.0 },
+	{ 2.0, 23.377, 0.7 }
+};
+
+const int BENCH_SINE_COUNT = sizeof(BENCH_SINES) / sizeof(BENCH_SINES[0]);
+
+struct BenchSample {
+	uint64_t uTimeNs;
+	double fRate;
+};
+
+static double TrueRate(double t)
+{
+	double fRate = 0.0;
+
+	for(int i = 0; i < BENCH_SINE_COUNT; i++)
+	{
+		fRate += BENCH_SINES[i].fAmplitude * sin(2.0 * M_PI * BENCH_SINES[i].fHz * t + BENCH_SINES[i].fPhase);
+	}
+
+	return(fRate);
+}
+
+static double TrueAngle(double t)
+{
+	double fAngle = 0.0;
+
+	for(int i = 0; i < BENCH_SINE_COUNT; i++)
+	{
+		double w = 2.0 * M_PI * BENCH_SINES[i].fHz;
+
+		fAngle += BENCH_SINES[i].fAmplitude / w * (cos(BENCH_SINES[i].fPhase) - cos(w * t + BENCH_SINES[i].fPhase));
+	}
+
+	return(fAngle);
+}
+
+///Same every run, so two runs print the same numbers
+static double Uniform(uint64_t *puState)
+{
+	*puState ^= *puState << 13;
+	*puState ^= *puState >> 7;
+	*puState ^= *puState << 17;
+	return((double)(*puState >> 11) / (double)(1ULL << 53));
+}
+
+static std::vector<BenchSample> MakeSamples(double fPeriod, double fJitter, bool bQuantize)
+{
+	std::vector<BenchSample> samples;
+	uint64_t uState = 0x9E3779B97F4A7C15ULL;
+	BenchSample sample;
+
+	for(int i = 0; i * fPeriod <= BENCH_SECONDS; i++)
+	{
+		double t = i * fPeriod + (2.0 * Uniform(&uState) - 1.0) * fJitter;
+
+		if(t < 0.0)
+		{
+			t = 0.0;
+		}
+
+		sample.uTimeNs = (uint64_t)(t * 1e9);
+		sample.fRate = TrueRate(sample.uTimeNs / 1e9);
+
+		if(bQuantize)
+		{
+			sample.fRate = floor(sample.fRate * BENCH_LSB_PER_DEG + 0.5) / BENCH_LSB_PER_DEG;
+		}
+
+		samples.push_back(sample);
+	}
+
+	return(samples);
+}
+
+///The angle ADXRS453Z used to keep: float, on float seconds, each interval at its end's rate
+static double LegacyAngle(const std::vector<BenchSample> &samples)
+{
+	float fAngle = 0.0;
+	float fLastTime = (float)(samples[0].uTimeNs / 1e9);
+
+	for(size_t i = 1; i < samples.size(); i++)
+	{
+		float fThisTime = (float)(samples[i].uTimeNs / 1e9);
+
+		fAngle += (float)samples[i].fRate * (fThisTime - fLastTime);
+		fLastTime = fThisTime;
+	}
+
+	return(fAngle);
+}
+
+static double Integrate(const std::vector<BenchSample> &samples, GyroIntegration scheme, double fBias)
+{
+	GyroIntegrator integrator(scheme);
+
+	for(size_t i = 0; i < samples.size(); i++)
+	{
+		integrator.Add(samples[i].fRate - fBias, samples[i].uTimeNs);
+	}
+
+	return(integrator.GetAngle());
+}
+
+static void RunSynthetic()
+{
+	const double fPeriods[] = { 0.010, 0.001 };
+	const double fJitters[] = { 0.0, 0.1 };		//of the period, either way
+
+	printf("synthetic %.0f s, drift deg/min (error at the end / minutes)\n", BENCH_SECONDS);
+	printf("%-8s %-8s %-6s %12s", "period", "jitter", "lsb", "legacy");
+
+	for(int s = 0; s < GYRO_INTEGRATE_LAST; s++)
+	{
+		printf(" %12s", GYRO_INTEGRATION_NAMES[s]);
+	}
+
+	printf("\n");
+
+	// without quantizing the error is all the scheme's, with it is what the robot sees
+
+	for(int q = 0; q < 2; q++)
+	{
+		for(int p = 0; p < 2; p++)
+		{
+			for(int j = 0; j < 2; j++)
+			{
+				std::vector<BenchSample> samples = MakeSamples(fPeriods[p], fJitters[j] * fPeriods[p], q == 1);
+				double fTruth = TrueAngle(samples.back().uTimeNs / 1e9) - TrueAngle(samples[0].uTimeNs / 1e9);
+				double fMinutes = (samples.back().uTimeNs - samples[0].uTimeNs) / 60e9;
+
+				printf("%5.0f us %6.0f%% %-6s %12.6f", fPeriods[p] * 1e6, fJitters[j] * 100.0, q ? "1/80" : "exact",
+						fabs(LegacyAngle(samples) - fTruth) / fMinutes);
+
+				for(int s = 0; s < GYRO_INTEGRATE_LAST; s++)
+				{
+					printf(" %12.6f", fabs(Integrate(samples, (GyroIntegration)s, 0.0) - fTruth) / fMinutes);
+				}
+
+				printf("\n");
+			}
+		}
+	}
+}
+
+///As ADXRS453Z::assemble_sensor_data
+static double DecodeRate(const DataLogRecord &record)
+{
+	uint8_t data[4];
+
+	for(int i = 0; i < 4; i++)
+	{
+		data[i] = (uint8_t)record.fValues[i];
+	}
+
+	return((short)(((short)(data[0] & 0x3)) << 14 | ((short)data[1]) << 6 | ((short)(data[2] & 0xFC)) >> 2)
+			/ BENCH_LSB_PER_DEG);
+}
+
+static bool RunRecorded(const char *szPath, double fCalibration)
+{
+	DataLogHeader header;
+	std::vector<DataLogRecord> records;
+	std::vector<BenchSample> samples;
+	BenchSample sample;
+	double fBias = 0.0;
+	int iCalibration = 0;
+	uint64_t uFirstNs = 0;
+	double fMinutes;
+
+	if(!ReadDataLog(szPath, &header, &records))
+	{
+		return(false);
+	}
+
+	for(size_t r = 0; r < records.size(); r++)
+	{
+		if((records[r].uType != DATALOG_TYPE_SPI) || (records[r].uSource != 0))
+		{
+			continue;
+		}
+
+		sample.uTimeNs = records[r].uTimeNs;
+		sample.fRate = DecodeRate(records[r]);
+
+		if(iCalibration == 0)
+		{
+			uFirstNs = sample.uTimeNs;
+		}
+
+		// the first seconds only measure the bias, like ADXRS453Z::Calibrate()
+
+		if((sample.uTimeNs - uFirstNs) / 1e9 < fCalibration)
+		{
+			fBias += sample.fRate;
+			iCalibration++;
+			continue;
+		}
+
+		samples.push_back(sample);
+	}
+
+	if((iCalibration == 0) || (samples.size() < 2))
+	{
+		fprintf(stderr, "%s has no gyro frames past the first %.1f s\n", szPath, fCalibration);
+		return(false);
+	}
+
+	fBias /= iCalibration;
+	fMinutes = (samples.back().uTimeNs - samples[0].uTimeNs) / 60e9;
+
+	printf("\n%s: %zu frames over %.1f min after %d for a bias of %.4f deg/s\n", szPath, samples.size(),
+			fMinutes, iCalibration, fBias);
+	printf("%-12s %12s %12s\n", "scheme", "angle", "deg/min");
+
+	for(int s = 0; s < GYRO_INTEGRATE_LAST; s++)
+	{
+		double fAngle = Integrate(samples, (GyroIntegration)s, fBias);
+
+		printf("%-12s %12.4f %12.4f\n", GYRO_INTEGRATION_NAMES[s], fAngle, fAngle / fMinutes);
+	}
+
+	return(true);
+}
+
+int main(int argc, char **argv)
+{
+	RunSynthetic();
+
+	if((argc >= 2) && !RunRecorded(argv[1], (argc >= 3) ? atof(argv[2]) : 10.0))
+	{
+		return(1);
+	}
+
+	return(0);
+}